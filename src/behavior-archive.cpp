@@ -0,0 +1,148 @@
+#include "behavior-archive.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+NoveltyArchive::NoveltyArchive(float cell_size, float speed_weight) {
+  this->cell_size_ = cell_size;
+  this->speed_weight_ = speed_weight;
+}
+
+void NoveltyArchive::Add(const BehaviorDescriptor& behavior) {
+  int cell_x = (int)floor(behavior.x / cell_size_);
+  int cell_y = (int)floor(behavior.y / cell_size_);
+  grid_[GetCellKey(cell_x, cell_y)].push_back(behaviors_.size());
+  behaviors_.push_back(behavior);
+}
+
+float NoveltyArchive::GetNovelty(const BehaviorDescriptor& behavior,
+  int neighbor_count) const {
+
+  if (behaviors_.empty() || neighbor_count <= 0) {
+    return 0;
+  }
+  neighbor_count = std::min(neighbor_count, (int)behaviors_.size());
+
+  int center_x = (int)floor(behavior.x / cell_size_);
+  int center_y = (int)floor(behavior.y / cell_size_);
+
+  // Max-heap of the nearest distances found so far
+  vector<float> nearest;
+  unsigned visited = 0;
+
+  // Search square rings of cells outward. Behaviors outside ring r are at
+  // least r * cell_size_ away, so the search stops once the k-th nearest
+  // distance is within that bound.
+  for (int ring = 0; visited < behaviors_.size(); ring++) {
+    for (int dx = -ring; dx <= ring; dx++) {
+      for (int dy = -ring; dy <= ring; dy++) {
+        if (std::max(abs(dx), abs(dy)) != ring) {
+          continue;
+        }
+        auto cell = grid_.find(GetCellKey(center_x + dx, center_y + dy));
+        if (cell == grid_.end()) {
+          continue;
+        }
+
+        for (int index : cell->second) {
+          visited++;
+          float distance = GetDistance(behavior, behaviors_[index]);
+          if ((int)nearest.size() < neighbor_count) {
+            nearest.push_back(distance);
+            std::push_heap(nearest.begin(), nearest.end());
+          } else if (distance < nearest.front()) {
+            std::pop_heap(nearest.begin(), nearest.end());
+            nearest.back() = distance;
+            std::push_heap(nearest.begin(), nearest.end());
+          }
+        }
+      }
+    }
+
+    if ((int)nearest.size() == neighbor_count
+      && nearest.front() <= ring * cell_size_) {
+      break;
+    }
+  }
+
+  float total = 0;
+  for (float distance : nearest) {
+    total += distance;
+  }
+  return total / nearest.size();
+}
+
+int NoveltyArchive::GetSize() const {
+  return behaviors_.size();
+}
+
+void NoveltyArchive::Clear() {
+  behaviors_.clear();
+  grid_.clear();
+}
+
+int64_t NoveltyArchive::GetCellKey(int cell_x, int cell_y) {
+  return ((int64_t)cell_x << 32) ^ (uint32_t)cell_y;
+}
+
+float NoveltyArchive::GetDistance(const BehaviorDescriptor& first,
+  const BehaviorDescriptor& second) const {
+  float dx = first.x - second.x;
+  float dy = first.y - second.y;
+  float dspeed = (first.speed - second.speed) * speed_weight_;
+  return sqrt(dx * dx + dy * dy + dspeed * dspeed);
+}
+
+EliteMap::EliteMap(float cell_size, float speed_bin_size) {
+  this->cell_size_ = cell_size;
+  this->speed_bin_size_ = speed_bin_size;
+}
+
+bool EliteMap::Insert(const BehaviorDescriptor& behavior, float fitness,
+  const double* genome, int genome_size) {
+
+  if (genome_size_ != genome_size) {
+    Clear();
+    genome_size_ = genome_size;
+  }
+
+  // Cells are keyed by 21 bits each of x, y and speed bin
+  int64_t cell_x = (int64_t)floor(behavior.x / cell_size_) & 0x1FFFFF;
+  int64_t cell_y = (int64_t)floor(behavior.y / cell_size_) & 0x1FFFFF;
+  int64_t speed_bin = (int64_t)floor(behavior.speed / speed_bin_size_)
+    & 0x1FFFFF;
+  int64_t key = (cell_x << 42) | (cell_y << 21) | speed_bin;
+
+  auto cell = cells_.find(key);
+  int index;
+  if (cell == cells_.end()) {
+    index = fitnesses_.size();
+    cells_[key] = index;
+    fitnesses_.push_back(fitness);
+    genomes_.resize(genomes_.size() + genome_size);
+  } else if (fitness > fitnesses_[cell->second]) {
+    index = cell->second;
+    fitnesses_[index] = fitness;
+  } else {
+    return false;
+  }
+
+  std::copy(genome, genome + genome_size,
+    genomes_.begin() + (size_t)index * genome_size);
+  return true;
+}
+
+const double* EliteMap::Sample(FastRandom& random_engine) const {
+  std::uniform_int_distribution<int> elite(0, fitnesses_.size() - 1);
+  return genomes_.data() + (size_t)elite(random_engine) * genome_size_;
+}
+
+int EliteMap::GetSize() const {
+  return fitnesses_.size();
+}
+
+void EliteMap::Clear() {
+  cells_.clear();
+  fitnesses_.clear();
+  genomes_.clear();
+}
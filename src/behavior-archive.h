@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include "fast-random.h"
+#include <unordered_map>
+#include <vector>
+
+using std::vector;
+
+// Summary of how a Car drove during one generation
+struct BehaviorDescriptor {
+  BehaviorDescriptor() {
+    this->x = 0;
+    this->y = 0;
+    this->speed = 0;
+  }
+
+  BehaviorDescriptor(float x, float y, float speed) {
+    this->x = x;
+    this->y = y;
+    this->speed = speed;
+  }
+
+  // Final position of the Car, which is its crash point if it crashed
+  float x;
+  float y;
+
+  // Average speed of the Car over the frames it drove
+  float speed;
+};
+
+// Archive of past behaviors for novelty search. Behaviors are indexed by a
+// uniform grid over position, so nearest-neighbour queries only visit cells
+// near the queried behavior however large the archive grows.
+class NoveltyArchive {
+
+public:
+
+  // Constructs archive with grid cells cell_size pixels wide. Speed
+  // differences are multiplied by speed_weight when measuring distance.
+  NoveltyArchive(float cell_size, float speed_weight);
+
+  // Adds a behavior to the archive
+  void Add(const BehaviorDescriptor& behavior);
+
+  // Returns mean distance from a behavior to its neighbor_count nearest
+  // archived behaviors, or 0 if the archive is empty
+  float GetNovelty(const BehaviorDescriptor& behavior,
+    int neighbor_count) const;
+
+  // Returns number of archived behaviors
+  int GetSize() const;
+
+  // Removes every archived behavior
+  void Clear();
+
+private:
+
+  float cell_size_;
+  float speed_weight_;
+
+  // Every archived behavior
+  vector<BehaviorDescriptor> behaviors_;
+
+  // Indices into behaviors_ of the behaviors in each grid cell
+  std::unordered_map<int64_t, vector<int>> grid_;
+
+  // Returns key of the grid cell containing a grid coordinate
+  static int64_t GetCellKey(int cell_x, int cell_y);
+
+  // Returns distance between two behaviors
+  float GetDistance(const BehaviorDescriptor& first,
+    const BehaviorDescriptor& second) const;
+};
+
+// MAP-Elites archive keeping the most fit genome found in each cell of a grid
+// over position and speed
+class EliteMap {
+
+public:
+
+  // Constructs map with cells cell_size pixels wide and speed_bin_size wide
+  // in speed
+  EliteMap(float cell_size, float speed_bin_size);
+
+  // Stores genome if its cell is empty or holds a less fit genome. Returns
+  // true if the genome was stored.
+  bool Insert(const BehaviorDescriptor& behavior, float fitness,
+    const double* genome, int genome_size);
+
+  // Returns a uniformly random stored genome. Map must not be empty.
+  const double* Sample(FastRandom& random_engine) const;
+
+  // Returns number of occupied cells
+  int GetSize() const;
+
+  // Removes every elite
+  void Clear();
+
+private:
+
+  float cell_size_;
+  float speed_bin_size_;
+  int genome_size_ = 0;
+
+  // Index of the elite stored for each occupied cell
+  std::unordered_map<int64_t, int> cells_;
+
+  // Fitness and genome of each elite. Genomes are stored one after another.
+  vector<float> fitnesses_;
+  vector<double> genomes_;
+};
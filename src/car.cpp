@@ -1,4 +1,5 @@
 #include "car.h"
+#include "fixed-point.h"
 
 Car::Car(Track* track, int id, NeuralNetwork* neural_network,
   string image_dir) {
@@ -13,6 +14,16 @@ Car::Car(Track* track, int id, string image_dir) {
   init(track, id, image_dir);
 }
 
+Car::Car(Track* track, int id, NeuralNetwork* neural_network) {
+  this->id_ = id;
+  this->track_ = track;
+  this->neural_network_ = neural_network;
+
+  position_ = track->GetStartPosition();
+  car_radius_ = kImageFill * sqrt(pow(kDefaultImageWidth, 2)
+    + pow(kDefaultImageHeight, 2)) / 2;
+}
+
 void Car::init(Track* track, int id, string image_dir) {
   image_.load(image_dir + "/car.png");
   this->id_ = id;
@@ -36,63 +47,85 @@ int Car::GetId() const {
 void Car::FrameUpdate(CarInputs inputs) {
   if (disabled_) return;
   
-  inputs.acceleration = CLAMP(inputs.acceleration,
-    -kMaxEffectiveInput, kMaxEffectiveInput);
-  inputs.turning = CLAMP(inputs.turning,
-    -kMaxEffectiveInput, kMaxEffectiveInput);
-
-  if (velocity_ > kMinVelocity) {
-    velocity_ += inputs.acceleration * kDefaultAcceleration / (abs(velocity_) + 1);
-  }
-
-  if (fabs(velocity_) > kMinTurningVelocity) {
-    rotation_rads_ += inputs.turning * kDefaultTurning;
-  }
+  inputs = ClampInputs(inputs);
 
-  position_[0] += velocity_ * cos(rotation_rads_) * GetScale();
-  position_[1] += velocity_ * sin(rotation_rads_) * GetScale();
+  if (deterministic_) {
+    FixedPhysicsUpdate(inputs);
+  } else {
+    if (velocity_ > kMinVelocity) {
+      velocity_ += inputs.acceleration * kDefaultAcceleration / (abs(velocity_) + 1);
+    }
 
-  if (abs(velocity_) < track_->GetTrackFriction()) {
-    velocity_ = 0;
-  }
-  else {
-    velocity_ > 0 ? velocity_ -= track_->GetTrackFriction()
-      : velocity_ += track_->GetTrackFriction();
-  }
+    if (fabs(velocity_) > kMinTurningVelocity) {
+      rotation_rads_ += inputs.turning * kDefaultTurning;
+    }
 
-  if (frame_count_ % kFitnessUpdateFrequency == 0) {
-    float curr_lap_dist = track_->FindDistAlongTrack(position_);
+    position_[0] += velocity_ * cos(rotation_rads_) * kDefaultScale;
+    position_[1] += velocity_ * sin(rotation_rads_) * kDefaultScale;
 
-    float fitness_diff = laps_completed_ * track_->GetTrackLength()
-      + curr_lap_dist - fitness_;
-    if (fabs(fitness_diff) > track_->GetTrackLength() / 2) {
-      fitness_diff > 0 ? laps_completed_ -= 1 : laps_completed_ += 1;
+    if (abs(velocity_) < track_->GetTrackFriction()) {
+      velocity_ = 0;
+    }
+    else {
+      velocity_ > 0 ? velocity_ -= track_->GetTrackFriction()
+        : velocity_ += track_->GetTrackFriction();
     }
-
-    fitness_ = laps_completed_ * track_->GetTrackLength() + curr_lap_dist;
   }
 
-  for (float bearing : kCornerBearings) {
-    if (CastRay(bearing) < car_radius_ * GetScale()) {
+  laps_completed_ += track_->AdvanceSegment(position_, &track_segment_);
+  fitness_is_current_ = false;
+
+  float collision_distance = car_radius_ * kDefaultScale;
+  int corner_distances[kMaxRayLanes];
+  CastRays(kCornerBearings.data(), kCornerBearings.size(), corner_distances);
+  for (unsigned i = 0; i < kCornerBearings.size(); i++) {
+    if (corner_distances[i] < collision_distance) {
       disabled_ = true;
     }
   }
 
+  speed_sum_ += fabs(velocity_);
   frame_count_++;
 }
 
 CarInputs Car::CalculateCarInputs() const {
+  return CalculateCarInputs(vector<const Car*>());
+}
+
+CarInputs Car::CalculateCarInputs(
+  const vector<const Car*>& nearby_cars) const {
   CarInputs car_inputs(0, 0);
   if (neural_network_ == nullptr) {
     return car_inputs;
   }
 
   // copy from std::vector to OpenNN::Vector
-  Vector<double> nn_inputs(kNnInputBearings.size() + 1);
+  assert(kNnInputBearings.size() + 1 == kNnInputCount);
+  Vector<double> nn_inputs(kNnInputCount);
+  int ray_distances[kMaxRayLanes];
+  CastRays(kNnInputBearings.data(), kNnInputBearings.size(), ray_distances);
   for (unsigned i = 0; i < kNnInputBearings.size(); i++) {
-    nn_inputs[i] = CastRay(kNnInputBearings[i]);
+    int distance = ray_distances[i];
+    for (const Car* other : nearby_cars) {
+      float distance_to_car = FindDistToCar(kNnInputBearings[i], *other);
+      if (distance_to_car >= 0 && distance_to_car + 1 < distance) {
+        distance = (int)distance_to_car + 1;
+      }
+    }
+    nn_inputs[i] = distance;
   }
   nn_inputs[nn_inputs.size() - 1] = velocity_;
+
+  if (quantized_network_ != nullptr
+    && quantized_network_->GetInputCount() <= (int)nn_inputs.size()) {
+    double nn_outputs[2];
+    assert(quantized_network_->GetOutputCount() == 2);
+    quantized_network_->CalculateOutputs(nn_inputs.data(), nn_outputs);
+    car_inputs.acceleration = nn_outputs[0];
+    car_inputs.turning = nn_outputs[1];
+    return car_inputs;
+  }
+
   Vector<double> nn_outputs = neural_network_->calculate_outputs(nn_inputs);
 
   assert(nn_outputs.size() == 2);
@@ -102,6 +135,36 @@ CarInputs Car::CalculateCarInputs() const {
   return car_inputs;
 }
 
+void Car::SetDecisionInterval(int decision_interval) {
+  decision_interval_ = std::max(decision_interval, 1);
+}
+
+bool Car::IsDecisionFrame() const {
+  return frame_count_ % decision_interval_ == 0;
+}
+
+CarInputs Car::NextInputs() {
+  if (IsDecisionFrame()) {
+    held_inputs_ = CalculateCarInputs();
+  }
+  return held_inputs_;
+}
+
+CarInputs Car::NextInputs(const vector<const Car*>& nearby_cars) {
+  if (IsDecisionFrame()) {
+    held_inputs_ = CalculateCarInputs(nearby_cars);
+  }
+  return held_inputs_;
+}
+
+CarInputs Car::ClampInputs(CarInputs inputs) const {
+  inputs.acceleration = CLAMP(inputs.acceleration,
+    -kMaxEffectiveInput, kMaxEffectiveInput);
+  inputs.turning = CLAMP(inputs.turning,
+    -kMaxEffectiveInput, kMaxEffectiveInput);
+  return inputs;
+}
+
 int Car::GetX() const {
   return (int)position_[0];
 }
@@ -110,14 +173,28 @@ int Car::GetY() const {
   return (int)position_[1];
 }
 
+float Car::GetBodyRadius() const {
+  return car_radius_ * kDefaultScale / 2;
+}
+
 float Car::GetScale() const {
   return kDefaultScale * track_->GetScale();
 }
 
 float Car::GetFitness() const {
+  if (!fitness_is_current_) {
+    fitness_ = laps_completed_ * track_->GetTrackLength()
+      + track_->GetDistAlongSegment(position_, track_segment_);
+    fitness_is_current_ = true;
+  }
   return fitness_;
 }
 
+void Car::SetFitness(float fitness) {
+  fitness_ = fitness;
+  fitness_is_current_ = true;
+}
+
 int Car::GetLaps() const {
   // The notion of negative laps completed does not make sense.
   // laps_completed can store negative values so fitness is tracked properly,
@@ -129,7 +206,15 @@ NeuralNetwork* Car::GetNeuralNetworkPointer() {
   return neural_network_;
 }
 
+void Car::SetQuantizedNetwork(const QuantizedNetwork* quantized_network) {
+  quantized_network_ = quantized_network;
+}
+
 int Car::CastRay(float bearing) const {
+  if (deterministic_) {
+    return FixedCastRay(bearing);
+  }
+
   float direction = rotation_rads_ + bearing; //radians cw from straight east
   vector<float> direction_ray{ cos(direction), sin(direction) };
   
@@ -145,20 +230,204 @@ int Car::CastRay(float bearing) const {
     ray_tip[1] -= direction_ray[1];
     distance -= 1;
   }
-  return distance * track_->GetScale() + 1;
+  return distance + 1;
+}
+
+void Car::CastRays(const float* bearings, int count, int* distances) const {
+  if (deterministic_) {
+    FixedCastRays(bearings, count, distances);
+    return;
+  }
+  for (int i = 0; i < count; i++) {
+    distances[i] = CastRay(bearings[i]);
+  }
+}
+
+float Car::FindDistToCar(float bearing, const Car& other) const {
+  float direction = rotation_rads_ + bearing;
+  float to_center_x = other.position_[0] - position_[0];
+  float to_center_y = other.position_[1] - position_[1];
+
+  // Ray-circle intersection: closest approach of the ray to the center,
+  // then back off to where the ray enters the circle
+  float along = to_center_x * cos(direction) + to_center_y * sin(direction);
+  if (along < 0) {
+    return -1;
+  }
+  float square_miss = to_center_x * to_center_x + to_center_y * to_center_y
+    - along * along;
+  float square_radius = pow(other.GetBodyRadius(), 2);
+  if (square_miss > square_radius) {
+    return -1;
+  }
+  return std::max(0.0f, along - sqrt(square_radius - square_miss));
 }
 
 float Car::GetRotation() const {
   return rotation_rads_;
 }
 
+void Car::SetDeterministic(bool deterministic) {
+  deterministic_ = deterministic;
+  if (deterministic_) {
+    fixed_x_ = FixedPoint::FromFloat(position_[0]);
+    fixed_y_ = FixedPoint::FromFloat(position_[1]);
+    fixed_velocity_ = FixedPoint::FromFloat(velocity_);
+    fixed_rotation_ = FixedPoint::AngleFromRadians(rotation_rads_);
+    SyncFloatState();
+  }
+}
+
+bool Car::IsDeterministic() const {
+  return deterministic_;
+}
+
+uint64_t Car::HashPhysicsState(uint64_t hash) const {
+  const uint64_t kFnvPrime = 1099511628211ULL;
+  uint32_t state[4] = { (uint32_t)fixed_x_, (uint32_t)fixed_y_,
+    (uint32_t)fixed_velocity_, fixed_rotation_ };
+
+  // Bytes are hashed least significant first regardless of platform
+  for (uint32_t value : state) {
+    for (int byte = 0; byte < 4; byte++) {
+      hash ^= (value >> (8 * byte)) & 0xFF;
+      hash *= kFnvPrime;
+    }
+  }
+  return hash;
+}
+
+void Car::FixedPhysicsUpdate(CarInputs inputs) {
+  int32_t acceleration = FixedPoint::FromFloat(inputs.acceleration);
+  int32_t turning = FixedPoint::FromFloat(inputs.turning);
+
+  if (fixed_velocity_ > FixedPoint::FromFloat(kMinVelocity)) {
+    int64_t impulse = (int64_t)acceleration
+      * FixedPoint::FromFloat(kDefaultAcceleration);
+    fixed_velocity_ += (int32_t)(impulse
+      / (abs(fixed_velocity_) + FixedPoint::kOne));
+  }
+
+  if (abs(fixed_velocity_) > FixedPoint::FromFloat(kMinTurningVelocity)) {
+    int64_t turning_per_input =
+      llround(kDefaultTurning * FixedPoint::kAngleUnitsPerRadian);
+    fixed_rotation_ += (uint32_t)((turning * turning_per_input)
+      >> FixedPoint::kShift);
+  }
+
+  int64_t step = ((int64_t)fixed_velocity_
+    * FixedPoint::FromFloat(kDefaultScale)) >> FixedPoint::kShift;
+  fixed_x_ += (int32_t)((step * FixedPoint::Cos(fixed_rotation_))
+    >> FixedPoint::kShift);
+  fixed_y_ += (int32_t)((step * FixedPoint::Sin(fixed_rotation_))
+    >> FixedPoint::kShift);
+
+  int32_t friction = FixedPoint::FromFloat(track_->GetTrackFriction());
+  if (abs(fixed_velocity_) < friction) {
+    fixed_velocity_ = 0;
+  } else {
+    fixed_velocity_ > 0 ? fixed_velocity_ -= friction
+      : fixed_velocity_ += friction;
+  }
+
+  SyncFloatState();
+}
+
+int Car::FixedCastRay(float bearing) const {
+  int distance;
+  FixedCastRays(&bearing, 1, &distance);
+  return distance;
+}
+
+void Car::FixedCastRays(const float* bearings, int count,
+  int* distances) const {
+  assert(count <= kMaxRayLanes);
+  int32_t direction_x[kMaxRayLanes];
+  int32_t direction_y[kMaxRayLanes];
+  int32_t tip_x[kMaxRayLanes];
+  int32_t tip_y[kMaxRayLanes];
+  int32_t moving[kMaxRayLanes];
+  for (int lane = 0; lane < count; lane++) {
+    uint32_t direction = fixed_rotation_
+      + FixedPoint::AngleFromRadians(bearings[lane]);
+    direction_x[lane] = FixedPoint::Cos(direction);
+    direction_y[lane] = FixedPoint::Sin(direction);
+    tip_x[lane] = fixed_x_;
+    tip_y[lane] = fixed_y_;
+    distances[lane] = 0;
+  }
+
+  // Step out until every ray has left the track. A ray off the track stays
+  // put, so it keeps reading as off until the slowest ray finishes.
+  bool any_moving = true;
+  while (any_moving) {
+    for (int lane = 0; lane < count; lane++) {
+      moving[lane] = track_->PointIsOnTrack(tip_x[lane] >> FixedPoint::kShift,
+        tip_y[lane] >> FixedPoint::kShift);
+    }
+    any_moving = false;
+    for (int lane = 0; lane < count; lane++) {
+      tip_x[lane] += moving[lane] * kRayCastGranularity * direction_x[lane];
+      tip_y[lane] += moving[lane] * kRayCastGranularity * direction_y[lane];
+      distances[lane] += moving[lane] * kRayCastGranularity;
+      any_moving |= moving[lane] != 0;
+    }
+  }
+
+  // Then step back one pixel at a time to the last point on the track
+  any_moving = true;
+  while (any_moving) {
+    for (int lane = 0; lane < count; lane++) {
+      moving[lane] = distances[lane] > 0 && !track_->PointIsOnTrack(
+        tip_x[lane] >> FixedPoint::kShift, tip_y[lane] >> FixedPoint::kShift);
+    }
+    any_moving = false;
+    for (int lane = 0; lane < count; lane++) {
+      tip_x[lane] -= moving[lane] * direction_x[lane];
+      tip_y[lane] -= moving[lane] * direction_y[lane];
+      distances[lane] -= moving[lane];
+      any_moving |= moving[lane] != 0;
+    }
+  }
+
+  for (int lane = 0; lane < count; lane++) {
+    distances[lane] += 1;
+  }
+}
+
+void Car::SyncFloatState() {
+  position_[0] = FixedPoint::ToFloat(fixed_x_);
+  position_[1] = FixedPoint::ToFloat(fixed_y_);
+  velocity_ = FixedPoint::ToFloat(fixed_velocity_);
+  rotation_rads_ = FixedPoint::AngleToRadians(fixed_rotation_);
+}
+
+float Car::GetAverageSpeed() const {
+  return frame_count_ == 0 ? 0 : speed_sum_ / frame_count_;
+}
+
 void Car::ResetPosition() {
   position_ = track_->GetStartPosition();
   fitness_ = 0;
+  fitness_is_current_ = true;
+  track_segment_ = 0;
   laps_completed_ = 0;
   rotation_rads_ = 0;
   velocity_ = 0;
+  frame_count_ = 0;
+  held_inputs_ = CarInputs();
+  speed_sum_ = 0;
   disabled_ = false;
+  SetDeterministic(deterministic_);
+}
+
+void Car::StartAtSegment(int segment) {
+  ResetPosition();
+  position_ = track_->GetSegmentStart(segment);
+  rotation_rads_ = track_->GetSegmentHeading(segment);
+  track_segment_ = segment;
+  fitness_is_current_ = false;
+  SetDeterministic(deterministic_);
 }
 
 bool Car::IsDisabled() const {
@@ -170,9 +439,9 @@ void Car::Disable() {
 }
 
 bool Car::operator> (const Car& other) const {
-  return this->fitness_ > other.GetFitness();
+  return GetFitness() > other.GetFitness();
 }
 
 bool Car::operator< (const Car& other) const {
-  return this->fitness_ < other.GetFitness();
+  return GetFitness() < other.GetFitness();
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include "track.h"
 #include "car-inputs.h"
+#include "quantized-network.h"
 #include "opennn.h"
 
 using namespace OpenNN;
@@ -11,6 +13,10 @@ class Car {
 
 public:
 
+  // Number of neural network inputs: one ray distance per bearing in
+  // kNnInputBearings, then velocity
+  static const int kNnInputCount = 6;
+
   // openFrameworks image of car
   ofImage image_;
   
@@ -26,6 +32,10 @@ public:
   // Constructs Car with defualt texture
   Car(Track* track, int id, string texture_path);
 
+  // Constructs Car controlled by neural network without loading an image.
+  // Safe to use off the GL thread for headless evaluation.
+  Car(Track* track, int id, NeuralNetwork* neural_network);
+
   // Sets image_ to blue car
   void ChangeImage(string image_path);
 
@@ -35,6 +45,31 @@ public:
   // Calculates CarInputs for a given frame using ray casts and the Car's NN
   CarInputs CalculateCarInputs() const;
 
+  // Calculates CarInputs with rays that also stop at nearby Cars
+  CarInputs CalculateCarInputs(const vector<const Car*>& nearby_cars) const;
+
+  // Makes the Car recalculate its inputs only every decision_interval frames
+  // and hold them in between. Collisions are still checked every frame.
+  void SetDecisionInterval(int decision_interval);
+
+  // Returns true if NextInputs recalculates inputs this frame
+  bool IsDecisionFrame() const;
+
+  // Returns inputs to drive with this frame: newly calculated on decision
+  // frames, otherwise the inputs held since the last decision
+  CarInputs NextInputs();
+  CarInputs NextInputs(const vector<const Car*>& nearby_cars);
+
+  // Returns distance to wall in a particular bearing (in radians).
+  int CastRay(float bearing) const;
+
+  // Writes CastRay of each of count bearings to distances. In deterministic
+  // physics the rays are cast together, one lane per ray.
+  void CastRays(const float* bearings, int count, int* distances) const;
+
+  // Returns inputs capped at the largest magnitude that affects the Car
+  CarInputs ClampInputs(CarInputs inputs) const;
+
   // Returns ID of car
   int GetId() const;
 
@@ -44,24 +79,58 @@ public:
   // Returns y-coordinate of Car's position
   int GetY() const;
 
-  // Returns scale of this Car
+  // Returns radius of the circle standing in for the Car's body when Cars
+  // collide with or sense each other
+  float GetBodyRadius() const;
+
+  // Returns scale this Car's image is drawn at on screen. Physics does not
+  // depend on it.
   float GetScale() const;
 
-  // Returns fitness of car as number of pixels around track
+  // Returns fitness of car as number of pixels around track. Computed from
+  // the Car's position the first time it is read after the Car moves.
   float GetFitness() const;
 
+  // Overrides fitness of car. Used when fitness is aggregated over several
+  // tracks at the end of a generation.
+  void SetFitness(float fitness);
+
   // Returns number of laps completed by the Car
   int GetLaps() const;
 
   // Returns pointer to Car's neural network
   NeuralNetwork* GetNeuralNetworkPointer();
 
+  // Makes Car drive with an integer copy of its neural network instead of
+  // the network itself. Pass nullptr to return to floating point. Not owned
+  // by the Car.
+  void SetQuantizedNetwork(const QuantizedNetwork* quantized_network);
+
   // Returns rotation of Car in radians
   float GetRotation() const;
 
+  // Switches between floating-point physics and deterministic fixed-point
+  // physics. Deterministic physics gives bit-identical trajectories on every
+  // platform.
+  void SetDeterministic(bool deterministic);
+
+  // Returns true if Car uses deterministic physics
+  bool IsDeterministic() const;
+
+  // Continues an FNV-1a hash with Car's deterministic physics state
+  uint64_t HashPhysicsState(uint64_t hash) const;
+
+  // Returns average speed of Car over the frames it has driven
+  float GetAverageSpeed() const;
+
   // Sets Car's position to Track's starting position
   void ResetPosition();
 
+  // Resets Car to the start of a track path segment, facing along it.
+  // Fitness still counts from the track's start, so progress from the
+  // segment is fitness minus the fitness read right after this call.
+  void StartAtSegment(int segment);
+
   // Returns true if Car has crashed
   bool IsDisabled() const;
 
@@ -76,12 +145,17 @@ public:
 
 private:
 
-  // Default scale of Car's image
+  // Scale of Car's image relative to the track's native pixels. Physics runs
+  // in native pixels at this scale whatever scale the track is drawn at.
   float kDefaultScale = 0.25;
 
   // Proportion of image's main diagonals filled by car matter
   float kImageFill = 0.86;
 
+  // Dimensions of car.png in pixels. Used for Cars without a loaded image.
+  float kDefaultImageWidth = 174;
+  float kDefaultImageHeight = 84;
+
   // Largest meaningful input for turning and acceleration. Larger
   // inputs will be capped at this value.
   float kMaxEffectiveInput = 4.0f;
@@ -108,10 +182,10 @@ private:
   vector<float> kCornerBearings = { -0.3735, 0.3735, 2.7869, 3.4963 };
 
   // Bearings to cast ray for neural network input
-  vector<double> kNnInputBearings = { -1, -0.5, 0, 0.5, 1 };
+  vector<float> kNnInputBearings = { -1, -0.5, 0, 0.5, 1 };
 
-  // Number of frames to wait before updating fitness
-  int kFitnessUpdateFrequency = 10;
+  // Most rays FixedCastRays casts at once
+  static const int kMaxRayLanes = 8;
 
   // Pointer to Track this Car is on
   Track* track_;
@@ -125,11 +199,42 @@ private:
   // Pointer to NeuralNetwork this car uses to determine how to drive
   NeuralNetwork* neural_network_ = nullptr;
 
+  // Quantized copy of neural_network_ used in its place. Null if inference
+  // is in floating point.
+  const QuantizedNetwork* quantized_network_ = nullptr;
+
   // Initializes Car object from Track and id. Called by both constructors.
   void init(Track* track, int id, string image_path);
 
-  // Returns distance to wall in a particular bearing (in radians).
-  int CastRay(float bearing) const;
+  // Returns distance along a bearing to another Car's body, or -1 if a ray
+  // in that bearing misses it
+  float FindDistToCar(float bearing, const Car& other) const;
+
+  // CastRay for deterministic physics, stepping in fixed-point
+  int FixedCastRay(float bearing) const;
+
+  // Casts up to kMaxRayLanes rays for deterministic physics in lock-step
+  // lanes, as FastRandom advances its lanes. Each round steps every ray
+  // still on the track with branch-free integer arithmetic, so the lanes
+  // vectorize apart from the track lookups, and every ray takes the same
+  // steps FixedCastRay would.
+  void FixedCastRays(const float* bearings, int count, int* distances) const;
+
+  // Updates velocity, rotation and position with fixed-point arithmetic
+  void FixedPhysicsUpdate(CarInputs inputs);
+
+  // Copies fixed-point state to the float state used by the rest of Car
+  void SyncFloatState();
+
+  // True if Car uses fixed-point physics
+  bool deterministic_ = false;
+
+  // Deterministic physics state. Position and velocity are Q16.16, rotation
+  // is in units of 2^-32 turns.
+  int32_t fixed_x_ = 0;
+  int32_t fixed_y_ = 0;
+  int32_t fixed_velocity_ = 0;
+  uint32_t fixed_rotation_ = 0;
 
   // Rotation of the Car in radians (0 is due east)
   float rotation_rads_ = 0;
@@ -141,8 +246,15 @@ private:
   float velocity_ = 0;
 
   // Distance the Car has made it around its track. A measure of the fitness
-  // (how good) this Car's NeuralNetwork can drive.
-  float fitness_ = 0;
+  // (how good) this Car's NeuralNetwork can drive. Only valid while
+  // fitness_is_current_ is true.
+  mutable float fitness_ = 0;
+
+  // False if the Car has moved since fitness_ was last computed
+  mutable bool fitness_is_current_ = true;
+
+  // Index of the track path segment nearest the Car, followed as it drives
+  int track_segment_ = 0;
 
   // Number of laps the Car has completed around track
   int laps_completed_ = 0;
@@ -150,6 +262,15 @@ private:
   // Number of times FrameUpdate() has been called since Car initialization
   int frame_count_ = 0;
 
+  // Number of frames between input calculations
+  int decision_interval_ = 1;
+
+  // Inputs calculated on the last decision frame
+  CarInputs held_inputs_;
+
+  // Sum of the Car's speed over every frame it has driven
+  float speed_sum_ = 0;
+
   // True if Car can no longer drive (crashed or manually disabled)
   bool disabled_ = false;
 };
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include "evolution-strategies.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+CmaEsOptimizer::CmaEsOptimizer(double initial_step_size) {
+  this->initial_step_size_ = initial_step_size;
+  random_engine_.Seed(std::random_device()());
+}
+
+void CmaEsOptimizer::Reset(int genome_size) {
+  int n = genome_size;
+  genome_size_ = n;
+  generation_ = 0;
+  step_size_ = initial_step_size_;
+
+  mean_.assign(n, 0);
+  covariance_.assign(n * n, 0);
+  eigenvectors_.assign(n * n, 0);
+  for (int i = 0; i < n; i++) {
+    covariance_[i * n + i] = 1;
+    eigenvectors_[i * n + i] = 1;
+  }
+  axis_lengths_.assign(n, 1);
+  covariance_path_.assign(n, 0);
+  step_size_path_.assign(n, 0);
+}
+
+void CmaEsOptimizer::Ask(int population_size, GenomePool* population) {
+  int n = genome_size_;
+  population->Resize(population_size, n);
+
+  vector<double> scaled(n);
+  for (int i = 0; i < population_size; i++) {
+    random_engine_.FillGaussian(scaled.data(), n, 0, 1);
+    for (int j = 0; j < n; j++) {
+      scaled[j] *= axis_lengths_[j];
+    }
+
+    // genome = mean + step_size * B * D * z
+    double* genome = population->GetGenome(i);
+    for (int row = 0; row < n; row++) {
+      double sum = 0;
+      for (int col = 0; col < n; col++) {
+        sum += eigenvectors_[row * n + col] * scaled[col];
+      }
+      genome[row] = mean_[row] + step_size_ * sum;
+    }
+  }
+}
+
+void CmaEsOptimizer::Tell(const GenomePool& population,
+  const vector<float>& fitness) {
+
+  int n = genome_size_;
+  int lambda = population.GetGenomeCount();
+  if (lambda < 2) {
+    return;
+  }
+
+  // Recombination weights and learning rates depend on the population size,
+  // which may change between generations
+  int mu = lambda / 2;
+  vector<double> weights(mu);
+  for (int i = 0; i < mu; i++) {
+    weights[i] = log(mu + 0.5) - log(i + 1.0);
+  }
+  double weight_sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+  double square_sum = 0;
+  for (double &weight : weights) {
+    weight /= weight_sum;
+    square_sum += weight * weight;
+  }
+  double mu_eff = 1 / square_sum;
+
+  double cc = (4 + mu_eff / n) / (n + 4 + 2 * mu_eff / n);
+  double cs = (mu_eff + 2) / (n + mu_eff + 5);
+  double c1 = 2 / ((n + 1.3) * (n + 1.3) + mu_eff);
+  double cmu = std::min(1 - c1,
+    2 * (mu_eff - 2 + 1 / mu_eff) / ((n + 2) * (n + 2) + mu_eff));
+  double damps = 1 + 2 * std::max(0.0, sqrt((mu_eff - 1) / (n + 1)) - 1) + cs;
+  double chi_n = sqrt(n) * (1 - 1.0 / (4 * n) + 1.0 / (21.0 * n * n));
+
+  vector<int> order(lambda);
+  std::iota(order.begin(), order.end(), 0);
+  std::partial_sort(order.begin(), order.begin() + mu, order.end(),
+    [&fitness](int first, int second) {
+      return fitness[first] > fitness[second];
+    });
+
+  // Steps of the selected genomes from the old mean, in units of step size
+  vector<double> steps(mu * n);
+  vector<double> mean_step(n, 0);
+  for (int k = 0; k < mu; k++) {
+    const double* genome = population.GetGenome(order[k]);
+    for (int j = 0; j < n; j++) {
+      steps[k * n + j] = (genome[j] - mean_[j]) / step_size_;
+      mean_step[j] += weights[k] * steps[k * n + j];
+    }
+  }
+  for (int j = 0; j < n; j++) {
+    mean_[j] += step_size_ * mean_step[j];
+  }
+
+  // C^(-1/2) * mean_step = B * D^-1 * B^T * mean_step
+  vector<double> rotated(n);
+  for (int i = 0; i < n; i++) {
+    double sum = 0;
+    for (int j = 0; j < n; j++) {
+      sum += eigenvectors_[j * n + i] * mean_step[j];
+    }
+    rotated[i] = sum / axis_lengths_[i];
+  }
+
+  double step_path_norm = 0;
+  double cs_factor = sqrt(cs * (2 - cs) * mu_eff);
+  for (int i = 0; i < n; i++) {
+    double sum = 0;
+    for (int j = 0; j < n; j++) {
+      sum += eigenvectors_[i * n + j] * rotated[j];
+    }
+    step_size_path_[i] = (1 - cs) * step_size_path_[i] + cs_factor * sum;
+    step_path_norm += step_size_path_[i] * step_size_path_[i];
+  }
+  step_path_norm = sqrt(step_path_norm);
+
+  generation_++;
+  // h_sigma: the covariance path only accumulates while the step-size path
+  // is short, so a rapidly growing step size does not stretch the
+  // covariance too
+  bool path_is_short = step_path_norm
+    / sqrt(1 - pow(1 - cs, 2.0 * generation_)) / chi_n < 1.4 + 2.0 / (n + 1);
+  double cc_factor = path_is_short ? sqrt(cc * (2 - cc) * mu_eff) : 0;
+  for (int i = 0; i < n; i++) {
+    covariance_path_[i] = (1 - cc) * covariance_path_[i]
+      + cc_factor * mean_step[i];
+  }
+
+  // Rank-one update from the evolution path plus rank-mu update from the
+  // selected steps
+  double c1_adjusted = c1 * (1 - (path_is_short ? 0 : cc * (2 - cc)));
+  for (int row = 0; row < n; row++) {
+    for (int col = 0; col <= row; col++) {
+      double rank_mu = 0;
+      for (int k = 0; k < mu; k++) {
+        rank_mu += weights[k] * steps[k * n + row] * steps[k * n + col];
+      }
+      double value = (1 - c1_adjusted - cmu) * covariance_[row * n + col]
+        + c1 * covariance_path_[row] * covariance_path_[col]
+        + cmu * rank_mu;
+      covariance_[row * n + col] = value;
+      covariance_[col * n + row] = value;
+    }
+  }
+
+  step_size_ *= exp(std::min(1.0, (cs / damps) * (step_path_norm / chi_n - 1)));
+  DecomposeCovariance();
+}
+
+string CmaEsOptimizer::GetName() const {
+  return "CMA-ES";
+}
+
+void CmaEsOptimizer::DecomposeCovariance() {
+  int n = genome_size_;
+  vector<double> matrix = covariance_;
+  std::fill(eigenvectors_.begin(), eigenvectors_.end(), 0);
+  for (int i = 0; i < n; i++) {
+    eigenvectors_[i * n + i] = 1;
+  }
+
+  // Cyclic Jacobi rotations. Genomes are small enough that this is cheaper
+  // than a tridiagonal reduction.
+  for (int sweep = 0; sweep < kMaxJacobiSweeps; sweep++) {
+    double off_diagonal = 0;
+    for (int p = 0; p < n; p++) {
+      for (int q = p + 1; q < n; q++) {
+        off_diagonal += matrix[p * n + q] * matrix[p * n + q];
+      }
+    }
+    if (off_diagonal < 1e-30) {
+      break;
+    }
+
+    for (int p = 0; p < n - 1; p++) {
+      for (int q = p + 1; q < n; q++) {
+        double apq = matrix[p * n + q];
+        if (apq == 0) {
+          continue;
+        }
+        double theta = (matrix[q * n + q] - matrix[p * n + p]) / (2 * apq);
+        double t = (theta >= 0 ? 1 : -1)
+          / (fabs(theta) + sqrt(theta * theta + 1));
+        double c = 1 / sqrt(t * t + 1);
+        double s = t * c;
+
+        for (int k = 0; k < n; k++) {
+          double akp = matrix[k * n + p];
+          double akq = matrix[k * n + q];
+          matrix[k * n + p] = c * akp - s * akq;
+          matrix[k * n + q] = s * akp + c * akq;
+        }
+        for (int k = 0; k < n; k++) {
+          double apk = matrix[p * n + k];
+          double aqk = matrix[q * n + k];
+          matrix[p * n + k] = c * apk - s * aqk;
+          matrix[q * n + k] = s * apk + c * aqk;
+        }
+        for (int k = 0; k < n; k++) {
+          double vkp = eigenvectors_[k * n + p];
+          double vkq = eigenvectors_[k * n + q];
+          eigenvectors_[k * n + p] = c * vkp - s * vkq;
+          eigenvectors_[k * n + q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    axis_lengths_[i] = sqrt(std::max(matrix[i * n + i], kMinEigenvalue));
+  }
+}
+
+AntitheticEsOptimizer::AntitheticEsOptimizer(
+  double noise_standard_deviation, double learning_rate) {
+  this->noise_standard_deviation_ = noise_standard_deviation;
+  this->learning_rate_ = learning_rate;
+  random_engine_.Seed(std::random_device()());
+}
+
+void AntitheticEsOptimizer::Reset(int genome_size) {
+  genome_size_ = genome_size;
+  step_ = 0;
+
+  std::uniform_real_distribution<double> parameter(-1, 1);
+  mean_.resize(genome_size);
+  for (double &value : mean_) {
+    value = parameter(random_engine_);
+  }
+  first_moment_.assign(genome_size, 0);
+  second_moment_.assign(genome_size, 0);
+}
+
+void AntitheticEsOptimizer::Ask(int population_size,
+  GenomePool* population) {
+
+  int n = genome_size_;
+  population->Resize(population_size, n);
+
+  vector<double> offsets(n);
+  for (int i = 0; i + 1 < population_size; i += 2) {
+    random_engine_.FillGaussian(offsets.data(), n, 0,
+      noise_standard_deviation_);
+    double* positive = population->GetGenome(i);
+    double* negative = population->GetGenome(i + 1);
+    for (int j = 0; j < n; j++) {
+      positive[j] = mean_[j] + offsets[j];
+      negative[j] = mean_[j] - offsets[j];
+    }
+  }
+
+  // An odd population evaluates the mean itself in the last slot
+  if (population_size % 2 == 1) {
+    std::copy(mean_.begin(), mean_.end(),
+      population->GetGenome(population_size - 1));
+  }
+}
+
+void AntitheticEsOptimizer::Tell(const GenomePool& population,
+  const vector<float>& fitness) {
+
+  int n = genome_size_;
+  int count = population.GetGenomeCount();
+  if (count < 2) {
+    return;
+  }
+
+  // Centered ranks in [-0.5, 0.5] make the update independent of the scale
+  // of fitness
+  vector<int> order(count);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&fitness](int first, int second) {
+    return fitness[first] < fitness[second];
+  });
+  vector<double> utility(count);
+  for (int rank = 0; rank < count; rank++) {
+    utility[order[rank]] = (double)rank / (count - 1) - 0.5;
+  }
+
+  vector<double> gradient(n, 0);
+  double variance = noise_standard_deviation_ * noise_standard_deviation_;
+  for (int i = 0; i < count; i++) {
+    const double* genome = population.GetGenome(i);
+    for (int j = 0; j < n; j++) {
+      gradient[j] += utility[i] * (genome[j] - mean_[j]);
+    }
+  }
+
+  step_++;
+  double first_correction = 1 - pow(kFirstMomentDecay, step_);
+  double second_correction = 1 - pow(kSecondMomentDecay, step_);
+  for (int j = 0; j < n; j++) {
+    double g = gradient[j] / (count * variance);
+    first_moment_[j] = kFirstMomentDecay * first_moment_[j]
+      + (1 - kFirstMomentDecay) * g;
+    second_moment_[j] = kSecondMomentDecay * second_moment_[j]
+      + (1 - kSecondMomentDecay) * g * g;
+    mean_[j] += learning_rate_ * (first_moment_[j] / first_correction)
+      / (sqrt(second_moment_[j] / second_correction) + kAdamEpsilon);
+  }
+}
+
+string AntitheticEsOptimizer::GetName() const {
+  return "Antithetic ES";
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <random>
+#include "fast-random.h"
+#include "optimizer.h"
+
+// Covariance matrix adaptation evolution strategy (CMA-ES). Samples each
+// generation from a multivariate normal distribution whose mean, step size
+// and covariance are adapted toward the most fit genomes. Suited to the
+// small genomes of the default architecture, where the full covariance is cheap.
+class CmaEsOptimizer : public Optimizer {
+
+public:
+
+  // Constructs optimizer with the initial step size of its distribution
+  explicit CmaEsOptimizer(double initial_step_size);
+
+  void Reset(int genome_size) override;
+  void Ask(int population_size, GenomePool* population) override;
+  void Tell(const GenomePool& population,
+    const vector<float>& fitness) override;
+  string GetName() const override;
+
+private:
+
+  // Number of Jacobi sweeps when decomposing the covariance matrix
+  int kMaxJacobiSweeps = 50;
+
+  // Smallest eigenvalue kept when decomposing the covariance matrix
+  double kMinEigenvalue = 1e-20;
+
+  double initial_step_size_;
+  int genome_size_ = 0;
+  int generation_ = 0;
+
+  // Mean of the search distribution
+  vector<double> mean_;
+
+  // Step size of the search distribution
+  double step_size_ = 0;
+
+  // Covariance matrix, row-major genome_size_ x genome_size_
+  vector<double> covariance_;
+
+  // Eigenvectors of covariance_ as columns, and square roots of their
+  // eigenvalues
+  vector<double> eigenvectors_;
+  vector<double> axis_lengths_;
+
+  // Evolution paths of the covariance matrix and of the step size
+  vector<double> covariance_path_;
+  vector<double> step_size_path_;
+
+  FastRandom random_engine_;
+
+  // Recomputes eigenvectors_ and axis_lengths_ from covariance_
+  void DecomposeCovariance();
+};
+
+// Evolution strategy estimating the gradient of fitness from mirrored
+// samples (theta + sigma * e, theta - sigma * e), as in OpenAI-ES. Fitness
+// is rank-transformed and the mean is updated with Adam.
+class AntitheticEsOptimizer : public Optimizer {
+
+public:
+
+  // Constructs optimizer with sampling noise and Adam learning rate
+  AntitheticEsOptimizer(double noise_standard_deviation,
+    double learning_rate);
+
+  void Reset(int genome_size) override;
+  void Ask(int population_size, GenomePool* population) override;
+  void Tell(const GenomePool& population,
+    const vector<float>& fitness) override;
+  string GetName() const override;
+
+private:
+
+  // Adam decay rates and numerical stabilizer
+  double kFirstMomentDecay = 0.9;
+  double kSecondMomentDecay = 0.999;
+  double kAdamEpsilon = 1e-8;
+
+  double noise_standard_deviation_;
+  double learning_rate_;
+  int genome_size_ = 0;
+  int step_ = 0;
+
+  // Center of the sampled genomes
+  vector<double> mean_;
+
+  // Adam moment estimates of the gradient
+  vector<double> first_moment_;
+  vector<double> second_moment_;
+
+  FastRandom random_engine_;
+};
@@ -0,0 +1,97 @@
+#include "fast-random.h"
+#include <algorithm>
+#include <cmath>
+
+// Converts the top 53 bits of a random word to a double in [0, 1)
+const double kUnitScale = 1.0 / 9007199254740992.0;
+
+const double kTwoPi = 6.283185307179586;
+
+FastRandom::FastRandom() {
+  Seed(kDefaultSeed);
+}
+
+FastRandom::FastRandom(uint64_t seed) {
+  Seed(seed);
+}
+
+void FastRandom::Seed(uint64_t seed) {
+  // SplitMix64 spreads one seed over every state word, as the xoshiro
+  // authors recommend
+  for (int word = 0; word < 4; word++) {
+    for (int lane = 0; lane < kLanes; lane++) {
+      seed += 0x9E3779B97F4A7C15ULL;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      state_[word][lane] = z ^ (z >> 31);
+    }
+  }
+  buffered_count_ = 0;
+}
+
+FastRandom::result_type FastRandom::operator()() {
+  if (buffered_count_ == 0) {
+    Step(buffered_);
+    buffered_count_ = kLanes;
+  }
+  return buffered_[--buffered_count_];
+}
+
+void FastRandom::FillUniform(double* values, int count, double low,
+  double high) {
+  double scale = (high - low) * kUnitScale;
+  uint64_t bits[kLanes];
+  int i = 0;
+  for (; i + kLanes <= count; i += kLanes) {
+    Step(bits);
+    for (int lane = 0; lane < kLanes; lane++) {
+      values[i + lane] = low + (bits[lane] >> 11) * scale;
+    }
+  }
+  for (; i < count; i++) {
+    values[i] = low + ((*this)() >> 11) * scale;
+  }
+}
+
+void FastRandom::FillGaussian(double* values, int count, double mean,
+  double standard_deviation) {
+  FillUniform(values, count, 0, 1);
+  for (int i = 0; i + 1 < count; i += 2) {
+    // 1 - u is in (0, 1], so the logarithm is finite
+    double radius = standard_deviation * sqrt(-2 * log(1 - values[i]));
+    double angle = kTwoPi * values[i + 1];
+    values[i] = mean + radius * cos(angle);
+    values[i + 1] = mean + radius * sin(angle);
+  }
+
+  if (count % 2 == 1) {
+    double pair[2];
+    FillUniform(pair, 2, 0, 1);
+    values[count - 1] = mean + standard_deviation
+      * sqrt(-2 * log(1 - pair[0])) * cos(kTwoPi * pair[1]);
+  }
+}
+
+void FastRandom::Step(uint64_t* out) {
+  uint64_t* s0 = state_[0];
+  uint64_t* s1 = state_[1];
+  uint64_t* s2 = state_[2];
+  uint64_t* s3 = state_[3];
+
+  // xoshiro256**, with its multiplications by 5 and 9 written as shifts and
+  // adds since SSE2 and AVX2 have no 64-bit multiply
+  for (int lane = 0; lane < kLanes; lane++) {
+    uint64_t times_five = (s1[lane] << 2) + s1[lane];
+    uint64_t rotated = (times_five << 7) | (times_five >> 57);
+    out[lane] = (rotated << 3) + rotated;
+
+    uint64_t t = s1[lane] << 17;
+    s2[lane] ^= s0[lane];
+    s3[lane] ^= s1[lane];
+    s1[lane] ^= s2[lane];
+    s0[lane] ^= s3[lane];
+    s2[lane] ^= t;
+    s3[lane] = (s3[lane] << 45) | (s3[lane] >> 19);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+// Random number generator for genetic operators and evolution strategies.
+// Runs kLanes independent xoshiro256** streams side by side. Filling an
+// array advances every lane with the same shifts, adds and xors, so the
+// compiler can keep the lanes in SIMD registers. Satisfies
+// UniformRandomBitGenerator, so standard distributions also accept it for
+// single draws.
+class FastRandom {
+
+public:
+
+  typedef uint64_t result_type;
+
+  // Constructs generator with a fixed default seed
+  FastRandom();
+
+  // Constructs generator from a seed
+  explicit FastRandom(uint64_t seed);
+
+  // Restarts every lane from a seed
+  void Seed(uint64_t seed);
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return UINT64_MAX; }
+
+  // Returns 64 random bits
+  result_type operator()();
+
+  // Fills values with count numbers uniformly distributed in [low, high)
+  void FillUniform(double* values, int count, double low, double high);
+
+  // Fills values with count normally distributed numbers. Uniform numbers
+  // are drawn in one batch and converted in pairs with the Box-Muller
+  // transform.
+  void FillGaussian(double* values, int count, double mean,
+    double standard_deviation);
+
+private:
+
+  // Number of xoshiro256** streams advanced together
+  static const int kLanes = 4;
+
+  // Seed used by the default constructor
+  static const uint64_t kDefaultSeed = 5489;
+
+  // Four state words of every lane, stored word-major so each word of all
+  // lanes is contiguous
+  uint64_t state_[4][kLanes];
+
+  // Outputs of the last step not yet returned by operator()
+  uint64_t buffered_[kLanes];
+  int buffered_count_ = 0;
+
+  // Advances every lane once and writes their outputs to out
+  void Step(uint64_t* out);
+};
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "fitness-cache.h"
+#include <cstring>
+
+namespace {
+
+  // FNV-1a 64-bit constants
+  const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+  const uint64_t kFnvPrime = 1099511628211ULL;
+
+  uint64_t HashBytes(const void* data, size_t length, uint64_t hash) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; i++) {
+      hash ^= bytes[i];
+      hash *= kFnvPrime;
+    }
+    return hash;
+  }
+}
+
+uint64_t FitnessCache::HashGenome(const NeuralNetwork* network) {
+  Vector<double> parameters =
+    network->get_multilayer_perceptron_pointer()->get_parameters();
+  return HashBytes(parameters.data(), parameters.size() * sizeof(double),
+    kFnvOffsetBasis);
+}
+
+uint64_t FitnessCache::HashContext(string track_folder, int start_segment,
+  int max_frames, bool deterministic, bool interacting, bool quantized,
+  int decision_interval) {
+
+  uint64_t hash = HashBytes(track_folder.data(), track_folder.size(),
+    kFnvOffsetBasis);
+  hash = HashBytes(&start_segment, sizeof(start_segment), hash);
+  hash = HashBytes(&max_frames, sizeof(max_frames), hash);
+  hash = HashBytes(&deterministic, sizeof(deterministic), hash);
+  hash = HashBytes(&interacting, sizeof(interacting), hash);
+  hash = HashBytes(&quantized, sizeof(quantized), hash);
+  return HashBytes(&decision_interval, sizeof(decision_interval), hash);
+}
+
+bool FitnessCache::Lookup(uint64_t genome_hash, uint64_t context_hash,
+  float* fitness) const {
+
+  auto entry = entries_.find(CombineHashes(genome_hash, context_hash));
+  if (entry == entries_.end()) {
+    return false;
+  }
+  *fitness = entry->second;
+  return true;
+}
+
+void FitnessCache::Store(uint64_t genome_hash, uint64_t context_hash,
+  float fitness) {
+
+  if (entries_.size() >= kMaxEntries) {
+    entries_.clear();
+  }
+  entries_[CombineHashes(genome_hash, context_hash)] = fitness;
+}
+
+void FitnessCache::Clear() {
+  entries_.clear();
+}
+
+int FitnessCache::GetSize() const {
+  return entries_.size();
+}
+
+uint64_t FitnessCache::CombineHashes(uint64_t genome_hash,
+  uint64_t context_hash) {
+  return genome_hash ^ (context_hash + 0x9e3779b97f4a7c15ULL
+    + (genome_hash << 6) + (genome_hash >> 2));
+}
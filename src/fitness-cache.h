@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "opennn.h"
+
+using namespace OpenNN;
+using std::string;
+
+// Remembers the fitness of NeuralNetworks that have already been fully
+// evaluated. Simulation is deterministic, so a network driven again on the
+// same track with the same simulation parameters earns the same fitness.
+class FitnessCache {
+
+public:
+
+  // Returns a hash of the parameters of a NeuralNetwork
+  static uint64_t HashGenome(const NeuralNetwork* network);
+
+  // Returns a hash identifying a track folder, the path segment Cars started
+  // at and the simulation parameters fitness was measured with
+  static uint64_t HashContext(string track_folder, int start_segment,
+    int max_frames, bool deterministic, bool interacting, bool quantized,
+    int decision_interval);
+
+  // Sets fitness to the cached value and returns true if one exists
+  bool Lookup(uint64_t genome_hash, uint64_t context_hash,
+    float* fitness) const;
+
+  // Stores the fitness of a fully evaluated genome
+  void Store(uint64_t genome_hash, uint64_t context_hash, float fitness);
+
+  // Removes every cached fitness
+  void Clear();
+
+  // Returns number of cached fitnesses
+  int GetSize() const;
+
+private:
+
+  // Cache is cleared when it grows past this many entries. Only elites are
+  // looked up, so old entries are rarely useful.
+  unsigned kMaxEntries = 100000;
+
+  // Cached fitness keyed by the combined genome and context hashes
+  std::unordered_map<uint64_t, float> entries_;
+
+  // Combines genome and context hashes into a single key
+  static uint64_t CombineHashes(uint64_t genome_hash, uint64_t context_hash);
+};
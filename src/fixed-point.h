@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// Q16.16 fixed-point arithmetic and table-based trigonometry used by the
+// deterministic physics mode. Only integer operations are involved, so
+// results are bit-identical across compilers, optimization flags and
+// platforms.
+namespace FixedPoint {
+
+  // Number of fractional bits in a fixed-point value
+  const int kShift = 16;
+
+  // Fixed-point representation of 1.0
+  const int32_t kOne = 1 << kShift;
+
+  // Angles are unsigned 32-bit integers where 2^32 is one full turn, so
+  // rotation wraps around without branches
+  const double kAngleUnitsPerRadian = 4294967296.0
+    / (2 * 3.14159265358979323846);
+
+  // Returns nearest fixed-point value to a float
+  int32_t FromFloat(float value);
+
+  // Returns float closest to a fixed-point value
+  float ToFloat(int32_t value);
+
+  // Returns nearest angle to a bearing in radians
+  uint32_t AngleFromRadians(double radians);
+
+  // Returns radians equivalent to an angle, in [0, 2 pi)
+  float AngleToRadians(uint32_t angle);
+
+  // Returns fixed-point sine and cosine of an angle. Interpolates linearly in
+  // a quarter-wave table of 257 entries.
+  int32_t Sin(uint32_t angle);
+  int32_t Cos(uint32_t angle);
+}
@@ -0,0 +1,377 @@
+#include "generation-log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+  // Identifies log files, their format version, and chunk headers
+  const uint32_t kLogMagic = 0x474F4C47; // "GLOG"
+  const uint32_t kLogVersion = 1;
+  const uint32_t kChunkMagic = 0x4B434C47; // "GLCK"
+
+  // Sizes in bytes of the file header, chunk header and index entries
+  const int kFileHeaderSize = 8;
+  const int kChunkHeaderSize = 24;
+  const int kIndexEntrySize = 12;
+
+  void AppendUint32(string* out, uint32_t value) {
+    for (int byte = 0; byte < 4; byte++) {
+      out->push_back((char)((value >> (8 * byte)) & 0xFF));
+    }
+  }
+
+  void AppendUint64(string* out, uint64_t value) {
+    AppendUint32(out, (uint32_t)value);
+    AppendUint32(out, (uint32_t)(value >> 32));
+  }
+
+  void AppendFloat(string* out, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    AppendUint32(out, bits);
+  }
+
+  void AppendDouble(string* out, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    AppendUint64(out, bits);
+  }
+
+  uint32_t ParseUint32(const char* data) {
+    uint32_t value = 0;
+    for (int byte = 0; byte < 4; byte++) {
+      value |= (uint32_t)(unsigned char)data[byte] << (8 * byte);
+    }
+    return value;
+  }
+
+  uint64_t ParseUint64(const char* data) {
+    return ParseUint32(data) | ((uint64_t)ParseUint32(data + 4) << 32);
+  }
+
+  float ParseFloat(const char* data) {
+    uint32_t bits = ParseUint32(data);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  double ParseDouble(const char* data) {
+    uint64_t bits = ParseUint64(data);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  // Reads the header of the chunk at position into header and returns
+  // the offset just past the chunk. Returns 0 if no complete chunk starts
+  // there, as when a crash cut the log short.
+  uint64_t ReadChunkHeader(std::istream& file, uint64_t position,
+    uint64_t file_size, char* header) {
+    if (position + kChunkHeaderSize > file_size) {
+      return 0;
+    }
+    file.seekg(position);
+    if (!file.read(header, kChunkHeaderSize)
+      || ParseUint32(header) != kChunkMagic) {
+      return 0;
+    }
+
+    uint64_t chunk_end = position + kChunkHeaderSize
+      + ParseUint64(header + 16)
+      + (uint64_t)ParseUint32(header + 4) * kIndexEntrySize;
+    return chunk_end <= file_size ? chunk_end : 0;
+  }
+}
+
+GenerationLogWriter::GenerationLogWriter(string path) {
+  std::ifstream existing(path, std::ios::binary | std::ios::ate);
+  uint64_t file_size = existing ? (uint64_t)existing.tellg() : 0;
+  bool is_new = file_size == 0;
+
+  // Find the end of the last complete chunk. Anything after it is a chunk
+  // a crash cut short, which would hide every chunk appended after it.
+  uint64_t log_end = file_size;
+  if (!is_new) {
+    char header[kChunkHeaderSize];
+    existing.seekg(0);
+    if (!existing.read(header, kFileHeaderSize)
+      || ParseUint32(header) != kLogMagic
+      || ParseUint32(header + 4) != kLogVersion) {
+      return;
+    }
+    log_end = kFileHeaderSize;
+    while (uint64_t chunk_end = ReadChunkHeader(existing, log_end,
+      file_size, header)) {
+      log_end = chunk_end;
+    }
+  }
+  existing.close();
+
+  if (log_end < file_size) {
+    std::error_code error;
+    std::filesystem::resize_file(path, log_end, error);
+    if (error) {
+      return;
+    }
+  }
+
+  file_.open(path, std::ios::binary | std::ios::app);
+  if (!file_) {
+    return;
+  }
+  if (is_new) {
+    string header;
+    AppendUint32(&header, kLogMagic);
+    AppendUint32(&header, kLogVersion);
+    file_.write(header.data(), header.size());
+    file_.flush();
+  }
+
+  is_open_ = true;
+  thread_ = std::thread(&GenerationLogWriter::Run, this);
+}
+
+GenerationLogWriter::~GenerationLogWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  records_available_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void GenerationLogWriter::Append(GenerationRecord record) {
+  if (!is_open_) {
+    dropped_count_++;
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.size() >= kMaxQueuedRecords) {
+      dropped_count_++;
+      return;
+    }
+    queue_.push_back(std::move(record));
+  }
+  records_available_.notify_one();
+}
+
+int GenerationLogWriter::GetDroppedCount() const {
+  return dropped_count_;
+}
+
+bool GenerationLogWriter::IsOpen() const {
+  return is_open_;
+}
+
+void GenerationLogWriter::Run() {
+  auto has_work = [this]() { return stopping_ || !queue_.empty(); };
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    // Records arriving do not push back the deadline of a partial chunk
+    if (chunk_index_.empty()) {
+      records_available_.wait(lock, has_work);
+    } else if (!records_available_.wait_until(lock, chunk_deadline_,
+      has_work)) {
+      lock.unlock();
+      WriteChunk();
+      lock.lock();
+      continue;
+    }
+    if (queue_.empty()) {
+      break;
+    }
+
+    GenerationRecord record = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+
+    if (chunk_index_.empty()) {
+      chunk_deadline_ = std::chrono::steady_clock::now()
+        + std::chrono::seconds(kFlushIntervalSeconds);
+    }
+    AddToChunk(record);
+    if (chunk_index_.size() >= kRecordsPerChunk
+      || std::chrono::steady_clock::now() >= chunk_deadline_) {
+      WriteChunk();
+    }
+    lock.lock();
+  }
+  lock.unlock();
+
+  if (!chunk_index_.empty()) {
+    WriteChunk();
+  }
+}
+
+void GenerationLogWriter::AddToChunk(const GenerationRecord& record) {
+  chunk_index_.push_back(std::make_pair(record.generation,
+    (uint64_t)chunk_records_.size()));
+
+  int top_count = record.top_fitnesses.size();
+  AppendUint32(&chunk_records_, record.generation);
+  AppendFloat(&chunk_records_, record.top_fitness);
+  AppendFloat(&chunk_records_, record.mean_fitness);
+  AppendUint32(&chunk_records_, record.disabled_count);
+  AppendUint32(&chunk_records_, record.frame_count);
+  AppendUint32(&chunk_records_, top_count);
+  AppendUint32(&chunk_records_, record.genome_size);
+  for (float fitness : record.top_fitnesses) {
+    AppendFloat(&chunk_records_, fitness);
+  }
+  for (double parameter : record.top_genomes) {
+    AppendDouble(&chunk_records_, parameter);
+  }
+}
+
+void GenerationLogWriter::WriteChunk() {
+  int first_generation = chunk_index_[0].first;
+  int last_generation = chunk_index_[0].first;
+  for (auto &entry : chunk_index_) {
+    first_generation = std::min(first_generation, entry.first);
+    last_generation = std::max(last_generation, entry.first);
+  }
+
+  string header;
+  AppendUint32(&header, kChunkMagic);
+  AppendUint32(&header, chunk_index_.size());
+  AppendUint32(&header, first_generation);
+  AppendUint32(&header, last_generation);
+  AppendUint64(&header, chunk_records_.size());
+
+  string index;
+  for (auto &entry : chunk_index_) {
+    AppendUint32(&index, entry.first);
+    AppendUint64(&index, entry.second);
+  }
+
+  file_.write(header.data(), header.size());
+  file_.write(chunk_records_.data(), chunk_records_.size());
+  file_.write(index.data(), index.size());
+  file_.flush();
+
+  chunk_records_.clear();
+  chunk_index_.clear();
+}
+
+bool GenerationLogReader::Open(string path) {
+  file_.open(path, std::ios::binary);
+  chunks_.clear();
+
+  char header[kChunkHeaderSize];
+  if (!file_.read(header, kFileHeaderSize)
+    || ParseUint32(header) != kLogMagic
+    || ParseUint32(header + 4) != kLogVersion) {
+    return false;
+  }
+
+  file_.seekg(0, std::ios::end);
+  uint64_t file_size = file_.tellg();
+
+  // Hop from chunk header to chunk header. A chunk cut short by a crash
+  // ends the log.
+  uint64_t position = kFileHeaderSize;
+  while (uint64_t chunk_end = ReadChunkHeader(file_, position, file_size,
+    header)) {
+    ChunkEntry chunk;
+    chunk.record_count = ParseUint32(header + 4);
+    chunk.first_generation = ParseUint32(header + 8);
+    chunk.last_generation = ParseUint32(header + 12);
+    chunk.records_offset = position + kChunkHeaderSize;
+    chunk.index_offset = chunk.records_offset + ParseUint64(header + 16);
+    chunks_.push_back(chunk);
+    position = chunk_end;
+  }
+  file_.clear();
+  return true;
+}
+
+int GenerationLogReader::GetFirstGeneration() const {
+  int first_generation = chunks_.empty() ? 0 : chunks_[0].first_generation;
+  for (const ChunkEntry& chunk : chunks_) {
+    first_generation = std::min(first_generation, chunk.first_generation);
+  }
+  return first_generation;
+}
+
+int GenerationLogReader::GetLastGeneration() const {
+  int last_generation = chunks_.empty() ? 0 : chunks_[0].last_generation;
+  for (const ChunkEntry& chunk : chunks_) {
+    last_generation = std::max(last_generation, chunk.last_generation);
+  }
+  return last_generation;
+}
+
+bool GenerationLogReader::Read(int generation, GenerationRecord* record) {
+  // Generation numbers restart when a population is reset, so the most
+  // recent chunk containing the generation wins
+  for (int c = chunks_.size() - 1; c >= 0; c--) {
+    const ChunkEntry& chunk = chunks_[c];
+    if (generation < chunk.first_generation
+      || generation > chunk.last_generation) {
+      continue;
+    }
+
+    vector<char> index(chunk.record_count * kIndexEntrySize);
+    file_.seekg(chunk.index_offset);
+    if (!file_.read(index.data(), index.size())) {
+      file_.clear();
+      return false;
+    }
+
+    for (int i = chunk.record_count - 1; i >= 0; i--) {
+      if ((int)ParseUint32(&index[i * kIndexEntrySize]) != generation) {
+        continue;
+      }
+
+      uint64_t start = chunk.records_offset
+        + ParseUint64(&index[i * kIndexEntrySize + 4]);
+      uint64_t end = i + 1 < chunk.record_count
+        ? chunk.records_offset
+          + ParseUint64(&index[(i + 1) * kIndexEntrySize + 4])
+        : chunk.index_offset;
+
+      if (end < start + 28) {
+        return false;
+      }
+      vector<char> data(end - start);
+      file_.seekg(start);
+      if (!file_.read(data.data(), data.size())) {
+        file_.clear();
+        return false;
+      }
+
+      record->generation = ParseUint32(&data[0]);
+      record->top_fitness = ParseFloat(&data[4]);
+      record->mean_fitness = ParseFloat(&data[8]);
+      record->disabled_count = ParseUint32(&data[12]);
+      record->frame_count = ParseUint32(&data[16]);
+      int top_count = ParseUint32(&data[20]);
+      record->genome_size = ParseUint32(&data[24]);
+
+      size_t expected_size = 28 + (size_t)top_count * 4
+        + (size_t)top_count * record->genome_size * 8;
+      if (data.size() < expected_size) {
+        return false;
+      }
+
+      const char* cursor = &data[28];
+      record->top_fitnesses.resize(top_count);
+      for (int k = 0; k < top_count; k++, cursor += 4) {
+        record->top_fitnesses[k] = ParseFloat(cursor);
+      }
+      record->top_genomes.resize((size_t)top_count * record->genome_size);
+      for (double &parameter : record->top_genomes) {
+        parameter = ParseDouble(cursor);
+        cursor += 8;
+      }
+      return true;
+    }
+  }
+  return false;
+}
\ No newline at end of file
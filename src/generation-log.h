@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Statistics and best genomes of one finished generation
+struct GenerationRecord {
+  int generation = 0;
+  float top_fitness = 0;
+  float mean_fitness = 0;
+
+  // Number of Cars that crashed and frames the generation ran for
+  int disabled_count = 0;
+  int frame_count = 0;
+
+  // Fitness and parameters of the most fit genomes, most fit first.
+  // Genomes are stored one after another.
+  int genome_size = 0;
+  vector<float> top_fitnesses;
+  vector<double> top_genomes;
+};
+
+// Appends GenerationRecords to a log file from a background thread so the
+// caller never waits on disk. Records are written in chunks, each followed by
+// an index block of record offsets, so memory use is bounded however long the
+// run and readers can seek to any generation.
+//
+// File layout: header, then chunks of
+// [chunk header][records][index: generation and offset of each record]
+class GenerationLogWriter {
+
+public:
+
+  // Opens log at path, appending if it already exists. A chunk cut short
+  // by a crash is truncated away first so appended chunks stay readable.
+  explicit GenerationLogWriter(string path);
+
+  // Writes queued records and stops the background thread
+  ~GenerationLogWriter();
+
+  // Queues record for writing. Never blocks on disk. Records are dropped if
+  // the writer falls more than kMaxQueuedRecords behind.
+  void Append(GenerationRecord record);
+
+  // Returns number of records dropped because the queue was full
+  int GetDroppedCount() const;
+
+  // Returns false if the log could not be opened or is not a log file.
+  // Appended records are then dropped.
+  bool IsOpen() const;
+
+private:
+
+  // Number of records gathered before a chunk is written
+  unsigned kRecordsPerChunk = 64;
+
+  // Largest number of records waiting for the background thread
+  unsigned kMaxQueuedRecords = 256;
+
+  // A chunk is written this long after its first record even if it is not
+  // full, so a crash loses little however slowly records arrive
+  int kFlushIntervalSeconds = 30;
+
+  std::ofstream file_;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable records_available_;
+  std::deque<GenerationRecord> queue_;
+  bool stopping_ = false;
+  std::atomic<int> dropped_count_{ 0 };
+  bool is_open_ = false;
+
+  // Serialized records and index entries of the chunk being gathered
+  string chunk_records_;
+  vector<std::pair<int, uint64_t>> chunk_index_;
+
+  // Time the chunk being gathered must be written by
+  std::chrono::steady_clock::time_point chunk_deadline_;
+
+  // Background thread loop
+  void Run();
+
+  // Serializes a record into the current chunk
+  void AddToChunk(const GenerationRecord& record);
+
+  // Writes the current chunk and its index block to file_
+  void WriteChunk();
+};
+
+// Reads a log written by GenerationLogWriter. Opening reads only the chunk
+// headers. Reading a generation reads one index block and one record.
+class GenerationLogReader {
+
+public:
+
+  // Opens log at path. Returns false if it is missing or not a log.
+  bool Open(string path);
+
+  // Returns first and last generation in the log
+  int GetFirstGeneration() const;
+  int GetLastGeneration() const;
+
+  // Reads record of a generation. Returns false if it is not in the log.
+  bool Read(int generation, GenerationRecord* record);
+
+private:
+
+  // Location and generation range of one chunk
+  struct ChunkEntry {
+    int first_generation;
+    int last_generation;
+    int record_count;
+    uint64_t records_offset;
+    uint64_t index_offset;
+  };
+
+  std::ifstream file_;
+  vector<ChunkEntry> chunks_;
+};
@@ -0,0 +1,44 @@
+#include "genetic-optimizer.h"
+
+GeneticOptimizer::GeneticOptimizer(int elite_count,
+  float rank_standard_deviation, int reference_population_size,
+  float mutation_rate) {
+  this->elite_count_ = elite_count;
+  this->rank_standard_deviation_ = rank_standard_deviation;
+  this->reference_population_size_ = reference_population_size;
+  selection_engine_.SetMutationRate(mutation_rate);
+}
+
+void GeneticOptimizer::Reset(int genome_size) {
+  genome_size_ = genome_size;
+  parents_.Resize(0, genome_size);
+  parent_fitness_.clear();
+}
+
+void GeneticOptimizer::Ask(int population_size, GenomePool* population) {
+  if (parents_.GetGenomeCount() == 0) {
+    population->Resize(population_size, genome_size_);
+    selection_engine_.Randomize(population);
+    return;
+  }
+
+  // Selection spreads over a larger part of larger populations
+  selection_engine_.SetRankStandardDeviation(rank_standard_deviation_
+    * parents_.GetGenomeCount() / reference_population_size_);
+  selection_engine_.Reproduce(parents_, parent_fitness_, elite_count_,
+    population_size, population);
+}
+
+void GeneticOptimizer::Tell(const GenomePool& population,
+  const vector<float>& fitness) {
+  parents_ = population;
+  parent_fitness_ = fitness;
+}
+
+string GeneticOptimizer::GetName() const {
+  return "Genetic algorithm";
+}
+
+SelectionEngine* GeneticOptimizer::GetSelectionEngine() {
+  return &selection_engine_;
+}
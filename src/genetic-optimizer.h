@@ -0,0 +1,40 @@
+#pragma once
+
+#include "optimizer.h"
+#include "selection-engine.h"
+
+// Genetic algorithm backend. Copies the most fit genomes unchanged and
+// fills the rest of each generation with mutated crossovers of selected
+// parents.
+class GeneticOptimizer : public Optimizer {
+
+public:
+
+  // Constructs optimizer copying elite_count genomes each generation.
+  // Rank selection spreads by rank_standard_deviation at
+  // reference_population_size and proportionally for other sizes.
+  GeneticOptimizer(int elite_count, float rank_standard_deviation,
+    int reference_population_size, float mutation_rate);
+
+  void Reset(int genome_size) override;
+  void Ask(int population_size, GenomePool* population) override;
+  void Tell(const GenomePool& population,
+    const vector<float>& fitness) override;
+  string GetName() const override;
+
+  // Returns engine used for selection and crossover
+  SelectionEngine* GetSelectionEngine();
+
+private:
+
+  int elite_count_;
+  float rank_standard_deviation_;
+  int reference_population_size_;
+  int genome_size_ = 0;
+
+  SelectionEngine selection_engine_;
+
+  // Genomes and fitness of the last evaluated generation
+  GenomePool parents_;
+  vector<float> parent_fitness_;
+};
@@ -0,0 +1,41 @@
+#include "genome-pool.h"
+
+GenomePool::GenomePool(int genome_count, int genome_size) {
+  Resize(genome_count, genome_size);
+}
+
+void GenomePool::Resize(int genome_count, int genome_size) {
+  genome_count_ = genome_count;
+  genome_size_ = genome_size;
+  genes_.resize((size_t)genome_count * genome_size);
+}
+
+int GenomePool::GetGenomeCount() const {
+  return genome_count_;
+}
+
+int GenomePool::GetGenomeSize() const {
+  return genome_size_;
+}
+
+double* GenomePool::GetGenome(int index) {
+  return genes_.data() + (size_t)index * genome_size_;
+}
+
+const double* GenomePool::GetGenome(int index) const {
+  return genes_.data() + (size_t)index * genome_size_;
+}
+
+void GenomePool::ReadNetwork(int index, const NeuralNetwork* network) {
+  Vector<double> parameters =
+    network->get_multilayer_perceptron_pointer()->get_parameters();
+  assert((int)parameters.size() == genome_size_);
+  std::copy(parameters.begin(), parameters.end(), GetGenome(index));
+}
+
+void GenomePool::WriteNetwork(int index, NeuralNetwork* network) const {
+  Vector<double> parameters(genome_size_);
+  std::copy(GetGenome(index), GetGenome(index) + genome_size_,
+    parameters.begin());
+  network->get_multilayer_perceptron_pointer()->set_parameters(parameters);
+}
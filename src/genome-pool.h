@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "opennn.h"
+
+using namespace OpenNN;
+using std::vector;
+
+// Parameters of many NeuralNetworks stored as rows of one contiguous array.
+// Genetic operators work on these rows instead of on nested OpenNN vectors.
+class GenomePool {
+
+public:
+
+  // Default constructor
+  GenomePool() { }
+
+  // Constructs pool of genome_count genomes with genome_size parameters each
+  GenomePool(int genome_count, int genome_size);
+
+  // Changes number and size of genomes. Contents are unspecified afterwards.
+  void Resize(int genome_count, int genome_size);
+
+  // Returns number of genomes in pool
+  int GetGenomeCount() const;
+
+  // Returns number of parameters in each genome
+  int GetGenomeSize() const;
+
+  // Returns pointer to first parameter of a genome
+  double* GetGenome(int index);
+  const double* GetGenome(int index) const;
+
+  // Copies parameters of a NeuralNetwork into a genome
+  void ReadNetwork(int index, const NeuralNetwork* network);
+
+  // Copies a genome into the parameters of a NeuralNetwork
+  void WriteNetwork(int index, NeuralNetwork* network) const;
+
+private:
+
+  int genome_count_ = 0;
+  int genome_size_ = 0;
+
+  // Parameters of every genome, one genome after another
+  vector<double> genes_;
+};
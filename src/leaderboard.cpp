@@ -0,0 +1,86 @@
+#include "leaderboard.h"
+#include <limits>
+#include <queue>
+
+void Leaderboard::Reset(int size) {
+  fitness_.assign(size, std::numeric_limits<float>::lowest());
+
+  leaf_offset_ = 1;
+  while (leaf_offset_ < size) {
+    leaf_offset_ *= 2;
+  }
+
+  winners_.assign(2 * leaf_offset_, -1);
+  for (int i = 0; i < size; i++) {
+    winners_[leaf_offset_ + i] = i;
+  }
+  for (int node = leaf_offset_ - 1; node >= 1; node--) {
+    winners_[node] = Play(winners_[2 * node], winners_[2 * node + 1]);
+  }
+}
+
+int Leaderboard::GetSize() const {
+  return fitness_.size();
+}
+
+void Leaderboard::Update(int index, float fitness) {
+  fitness_[index] = fitness;
+  for (int node = (leaf_offset_ + index) / 2; node >= 1; node /= 2) {
+    winners_[node] = Play(winners_[2 * node], winners_[2 * node + 1]);
+  }
+}
+
+LeaderboardEntry Leaderboard::GetLeader() const {
+  if (fitness_.empty()) {
+    return LeaderboardEntry();
+  }
+  int leader = winners_[1];
+  return LeaderboardEntry(leader, fitness_[leader]);
+}
+
+vector<LeaderboardEntry> Leaderboard::GetTop(int count) const {
+  vector<LeaderboardEntry> top;
+  if (fitness_.empty() || count <= 0) {
+    return top;
+  }
+
+  // A node's winner beats everything below it, so taking nodes best first
+  // reaches leaves in fitness order. A tied winner is the lowest index below
+  // its node, so breaking ties by index ranks tied slots as GetLeader does.
+  auto lower_winner = [this](int first_node, int second_node) {
+    int first = winners_[first_node];
+    int second = winners_[second_node];
+    return fitness_[second] > fitness_[first]
+      || (fitness_[second] == fitness_[first] && second < first);
+  };
+  std::priority_queue<int, vector<int>, decltype(lower_winner)>
+    frontier(lower_winner);
+  frontier.push(1);
+
+  while (!frontier.empty() && (int)top.size() < count) {
+    int node = frontier.top();
+    frontier.pop();
+
+    if (node >= leaf_offset_) {
+      top.push_back(LeaderboardEntry(winners_[node],
+        fitness_[winners_[node]]));
+      continue;
+    }
+    for (int child : { 2 * node, 2 * node + 1 }) {
+      if (winners_[child] >= 0) {
+        frontier.push(child);
+      }
+    }
+  }
+  return top;
+}
+
+int Leaderboard::Play(int first, int second) const {
+  if (first < 0) {
+    return second;
+  }
+  if (second < 0) {
+    return first;
+  }
+  return fitness_[second] > fitness_[first] ? second : first;
+}
\ No newline at end of file
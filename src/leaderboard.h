@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+
+using std::vector;
+
+// Position of one slot on a Leaderboard
+struct LeaderboardEntry {
+  LeaderboardEntry() {
+    this->index = -1;
+    this->fitness = 0;
+  }
+
+  LeaderboardEntry(int index, float fitness) {
+    this->index = index;
+    this->fitness = fitness;
+  }
+
+  // Slot the entry belongs to, such as a Car's index in the population
+  int index;
+  float fitness;
+};
+
+// Ranks a fixed number of slots by fitness as their fitness changes. Kept as
+// a tournament tree: each node holds the winner of its two children, so an
+// update replays only the matches on one leaf-to-root path and the leader is
+// read from the root without scanning.
+class Leaderboard {
+
+public:
+
+  // Sets number of slots and resets each slot's fitness to the lowest value
+  void Reset(int size);
+
+  // Returns number of slots
+  int GetSize() const;
+
+  // Sets fitness of a slot. Takes time logarithmic in the number of slots.
+  void Update(int index, float fitness);
+
+  // Returns the slot with the highest fitness. Ties go to the lower index.
+  // Returns an entry with index -1 if there are no slots.
+  LeaderboardEntry GetLeader() const;
+
+  // Returns up to count slots with the highest fitness, highest first and
+  // ties to the lower index. Only visits the tree nodes that can hold one of
+  // them.
+  vector<LeaderboardEntry> GetTop(int count) const;
+
+private:
+
+  // Fitness of each slot
+  vector<float> fitness_;
+
+  // Winning slot of each tree node, or -1 for padding. Node 1 is the root,
+  // node i has children 2i and 2i + 1, and leaves start at leaf_offset_.
+  vector<int> winners_;
+
+  int leaf_offset_ = 1;
+
+  // Returns the winner of a match between two slots
+  int Play(int first, int second) const;
+};
\ No newline at end of file
@@ -1,14 +1,42 @@
 #include "learning-model.h"
+#include "ofFileUtils.h"
+#include "ofLog.h"
+#include <numeric>
 
 LearningModel::LearningModel(string assets_path, int track_number) {
+  Configure(TrainingConfig());
+
+  this->assets_path = assets_path;
+  SetTrack(assets_path + "/track" + std::to_string(track_number));
+}
+
+LearningModel::LearningModel(Track* shared_track, string track_folder,
+  TrainingConfig config) {
+  Configure(config);
+
+  track_ = shared_track;
+  track_folder_ = track_folder;
+}
+
+LearningModel::~LearningModel() {
+  CancelTrackEvaluations();
+  CollectChampionReplay(true);
+}
+
+void LearningModel::Configure(TrainingConfig config) {
+  config_ = config;
+
   // OpenNN::Vector cannot be initialized from literal values
-  for (unsigned layer_size : kArchitecture) {
+  architecture_.clear();
+  for (unsigned layer_size : config_.architecture) {
     architecture_.push_back(layer_size);
   }
-  population_size_ = kDefaultPopulationSize;
-  
-  this->assets_path = assets_path;
-  SetTrack(assets_path + "/track" + std::to_string(track_number));
+  population_size_ = config_.population_size;
+  genome_size_ = NeuralNetwork(architecture_)
+    .get_multilayer_perceptron_pointer()->count_parameters_number();
+  optimizer_.reset(new GeneticOptimizer(config_.copy_to_next_generation,
+    config_.selection_standard_deviation, config_.population_size,
+    config_.mutation_rate));
 }
 
 Track* LearningModel::GetTrack() const {
@@ -16,33 +44,142 @@ Track* LearningModel::GetTrack() const {
 }
 
 void LearningModel::SetTrack(string track_folder) {
-  if (track_ != nullptr) {
-    delete track_;
+  InstallTrack(std::unique_ptr<Track>(new Track(track_folder)),
+    track_folder);
+}
+
+void LearningModel::LoadTrackAsync(string track_folder) {
+  // Replacing the future of a running load would block until it finishes
+  if (pending_track_.valid()) {
+    queued_track_folder_ = track_folder;
+    return;
   }
-  track_ = new Track(track_folder);
-  if (!population_.empty()) {
-    StartNextGeneration();
+
+  pending_track_folder_ = track_folder;
+  pending_track_ = std::async(std::launch::async, [track_folder]() {
+    return std::unique_ptr<Track>(new Track(track_folder));
+  });
+}
+
+bool LearningModel::IsTrackLoading() const {
+  return pending_track_.valid();
+}
+
+bool LearningModel::FinishTrackLoad() {
+  if (!pending_track_.valid() || pending_track_.wait_for(
+    std::chrono::seconds(0)) != std::future_status::ready) {
+    return false;
   }
+
+  // A track requested while this one loaded replaces it
+  std::unique_ptr<Track> loaded_track = pending_track_.get();
+  if (!queued_track_folder_.empty()) {
+    string queued_folder = queued_track_folder_;
+    queued_track_folder_.clear();
+    LoadTrackAsync(queued_folder);
+    return false;
+  }
+
+  loaded_track->SetScale(track_->GetScale());
+  InstallTrack(std::move(loaded_track), pending_track_folder_);
+  return true;
 }
 
-void LearningModel::SetAutoAdvanceGeneration(bool auto_advance_generation) {
-  this->auto_advance_generation = auto_advance_generation;
+void LearningModel::InstallTrack(std::unique_ptr<Track> track,
+  string track_folder) {
+  // The finishing generation is scored on the track it drove, and its Cars
+  // are replaced before that track is deleted on return
+  std::unique_ptr<Track> old_track = std::move(owned_track_);
+  bool has_population = !population_.empty();
+  if (has_population) {
+    FinishGeneration();
+  }
+  track_ = track.get();
+  track_folder_ = track_folder;
+  owned_track_ = std::move(track);
+  if (has_population) {
+    BeginGeneration();
+  }
+
+  // The finishing generation's champion may still be driving on old_track
+  CollectChampionReplay(true);
 }
 
-void LearningModel::GenerateRandom() {
-  DeleteOldGeneration();
-  population_.clear();
+void LearningModel::SetEvaluationTracks(vector<string> track_folders) {
+  vector<std::unique_ptr<Track>> tracks;
+  for (string folder : track_folders) {
+    tracks.push_back(std::unique_ptr<Track>(new Track(folder)));
+  }
+  InstallEvaluationTracks(std::move(tracks), track_folders);
+}
 
-  for (int i = 0; i < population_size_; i++) {
-    NeuralNetwork* random_network = new NeuralNetwork(architecture_);
-    random_network->randomize_parameters_uniform();
-    random_network->construct_scaling_layer();
+void LearningModel::LoadEvaluationTracksAsync(vector<string> track_folders) {
+  // Replacing the future of a running load would block until it finishes
+  if (pending_evaluation_tracks_.valid()) {
+    queued_evaluation_track_folders_ = track_folders;
+    has_queued_evaluation_tracks_ = true;
+    return;
+  }
 
-    population_.push_back(Car(track_, i, random_network, assets_path));
+  pending_evaluation_track_folders_ = track_folders;
+  pending_evaluation_tracks_ = std::async(std::launch::async,
+    [track_folders]() {
+      vector<std::unique_ptr<Track>> tracks;
+      for (string folder : track_folders) {
+        tracks.push_back(std::unique_ptr<Track>(new Track(folder)));
+      }
+      return tracks;
+    });
+}
+
+bool LearningModel::FinishEvaluationTrackLoad() {
+  if (!pending_evaluation_tracks_.valid()
+    || pending_evaluation_tracks_.wait_for(std::chrono::seconds(0))
+      != std::future_status::ready) {
+    return false;
+  }
+
+  // Folders requested while these loaded replace them
+  vector<std::unique_ptr<Track>> tracks = pending_evaluation_tracks_.get();
+  if (has_queued_evaluation_tracks_) {
+    has_queued_evaluation_tracks_ = false;
+    LoadEvaluationTracksAsync(queued_evaluation_track_folders_);
+    return false;
   }
 
+  InstallEvaluationTracks(std::move(tracks),
+    pending_evaluation_track_folders_);
+  return true;
+}
+
+void LearningModel::InstallEvaluationTracks(
+  vector<std::unique_ptr<Track>> tracks, vector<string> track_folders) {
+  CancelTrackEvaluations();
+  evaluation_tracks_ = std::move(tracks);
+  evaluation_track_folders_ = track_folders;
+  LaunchTrackEvaluations();
+}
+
+void LearningModel::SetAutoAdvanceGeneration(bool auto_advance_generation) {
+  this->auto_advance_generation = auto_advance_generation;
+}
+
+void LearningModel::SetFitnessCacheEnabled(bool use_fitness_cache) {
+  this->use_fitness_cache_ = use_fitness_cache;
+}
+
+void LearningModel::GenerateRandom() {
+  optimizer_->Reset(genome_size_);
+  optimizer_->Ask(population_size_, &offspring_genomes_);
+  PopulateFromGenomes(0);
+
   generation_number_ = 1;
+  last_generation_top_fitness_ = 0;
   disabled_count_ = 0;
+  generation_checkpoint_count_ = checkpoint_count_;
+  generation_context_ = GetFitnessContext(track_folder_, 0);
+  RebuildLeaderboard();
+  LaunchTrackEvaluations();
 }
 
 vector<Car>* LearningModel::GetCars() {
@@ -51,20 +188,37 @@ vector<Car>* LearningModel::GetCars() {
 
 void LearningModel::FrameUpdate() {
   if (!auto_advance_generation
-    || (generation_frame_count_ < kMaxGenerationFrames
+    || (generation_frame_count_ < GetGenerationFrameLimit()
       && disabled_count_ < population_size_)
     ) {
-    for (Car &car : population_) {
+    bool update_leaderboard =
+      generation_frame_count_ % kLeaderboardUpdateFrequency == 0;
+    if (interacting_cars_) {
+      RebuildCarHash();
+    }
+    for (unsigned i = 0; i < population_.size(); i++) {
+      Car &car = population_[i];
       if (car.IsDisabled()) {
         continue;
       }
 
-      CarInputs inputs = car.CalculateCarInputs();
+      CarInputs inputs = interacting_cars_ && car.IsDecisionFrame()
+        ? car.NextInputs(FindNearbyCars(car))
+        : car.NextInputs();
       car.FrameUpdate(inputs);
       if (car.IsDisabled()) {
         disabled_count_++;
+        leaderboard_.Update(i, car.GetFitness());
+      } else if (update_leaderboard) {
+        leaderboard_.Update(i, car.GetFitness());
       }
     }
+
+    // Cars crash into where each other ended up this frame
+    if (interacting_cars_) {
+      RebuildCarHash();
+      ResolveCarCollisions();
+    }
   }
   else {
     StartNextGeneration();
@@ -81,88 +235,620 @@ int LearningModel::GetGenerationNumber() const {
 }
 
 float LearningModel::GetTopFitness() const {
-  Car most_fit = *std::max_element(population_.begin(),
-    population_.end(), std::less<Car>());
-
-  return most_fit.GetFitness();
+  return leaderboard_.GetLeader().fitness;
 }
 
-void LearningModel::StartNextGeneration() {
-  std::sort(population_.begin(), population_.end(), std::greater<Car>());
-  vector<Car> new_population(population_size_);
+float LearningModel::GetLastGenerationTopFitness() const {
+  return last_generation_top_fitness_;
+}
 
-  Vector<int> random_indices(population_size_ * 2);
-  random_indices.randomize_normal(0, kSelectionStandardDeviation *
-    population_.size() / kDefaultPopulationSize);
-  random_indices.apply_absolute_value();
-  random_indices.apply_upper_bound(population_.size() - 1);
+vector<LeaderboardEntry> LearningModel::GetLeaderboard(int count) const {
+  return leaderboard_.GetTop(count);
+}
 
-  for (unsigned i = 0; i < kCopyToNextGeneration
-    && i < new_population.size(); i++) {
-    NeuralNetwork* offspring_network = new NeuralNetwork(
-      *population_[i % population_.size()].GetNeuralNetworkPointer());
+void LearningModel::StartNextGeneration() {
+  FinishGeneration();
+  BeginGeneration();
+}
 
-    new_population[i] = Car(track_,
-      generation_number_ * population_size_ + i,
-      offspring_network, assets_path);
+void LearningModel::FinishGeneration() {
+  StoreEvaluatedFitness();
+  ApplyTrackEvaluations();
+  RebuildLeaderboard();
+  if (!population_.empty()) {
+    last_generation_top_fitness_ = GetTopFitness();
+  }
+  if (!replay_directory_.empty() && !population_.empty()) {
+    RecordChampionReplay();
   }
 
-  for (int i = kCopyToNextGeneration; i < population_size_; i++) {
+  vector<float> fitness(population_.size());
+  parent_genomes_.Resize(population_.size(), genome_size_);
+  for (unsigned i = 0; i < population_.size(); i++) {
+    fitness[i] = population_[i].GetFitness();
+    parent_genomes_.ReadNetwork(i, population_[i].GetNeuralNetworkPointer());
+  }
+  if (generation_log_ && !population_.empty()) {
+    LogGeneration(fitness);
+  }
 
-    NeuralNetwork* parent_one = population_[random_indices[i * 2]]
-      .GetNeuralNetworkPointer();
-    NeuralNetwork* parent_two = population_[random_indices[i * 2 + 1]]
-      .GetNeuralNetworkPointer();
-    NeuralNetwork* offspring_network =
-      RecombineNeuralNetworks(parent_one, parent_two);
+  if (search_mode_ == SearchMode::kNovelty) {
+    // Novelty is measured against earlier generations only, so a behavior
+    // shared by many Cars this generation is still rewarded once
+    vector<BehaviorDescriptor> behaviors = GetBehaviors();
+    for (unsigned i = 0; i < behaviors.size(); i++) {
+      fitness[i] = novelty_archive_.GetNovelty(behaviors[i],
+        kNoveltyNeighbors);
+    }
+    for (const BehaviorDescriptor& behavior : behaviors) {
+      novelty_archive_.Add(behavior);
+    }
+  }
 
-    new_population[i] = Car(track_, generation_number_ * population_size_ + i,
-      offspring_network, assets_path);
+  if (search_mode_ == SearchMode::kMapElites) {
+    vector<BehaviorDescriptor> behaviors = GetBehaviors();
+    for (unsigned i = 0; i < behaviors.size(); i++) {
+      elite_map_.Insert(behaviors[i], fitness[i],
+        parent_genomes_.GetGenome(i), genome_size_);
+    }
+    ProduceMapElitesOffspring();
+  } else {
+    optimizer_->Tell(parent_genomes_, fitness);
+    optimizer_->Ask(population_size_, &offspring_genomes_);
   }
+}
 
-  DeleteOldGeneration();
-  population_ = new_population;
+void LearningModel::BeginGeneration() {
+  PopulateFromGenomes(generation_number_ * population_size_);
   generation_frame_count_ = 0;
   disabled_count_ = 0;
   generation_number_++;
+  generation_checkpoint_count_ = checkpoint_count_;
+  generation_context_ = GetFitnessContext(track_folder_, 0);
+  ApplyCachedFitness();
+  RebuildLeaderboard();
+  LaunchTrackEvaluations();
 }
 
 void LearningModel::SetPopulationSize(int new_size) {
   if (new_size < 0) {
-    population_size_ = kDefaultPopulationSize;
+    population_size_ = config_.population_size;
   } else {
     population_size_ = new_size;
   }
   StartNextGeneration();
 }
 
-NeuralNetwork* LearningModel::RecombineNeuralNetworks(NeuralNetwork* first,
-  NeuralNetwork* second) {
+void LearningModel::SetOptimizer(OptimizerType optimizer_type) {
+  switch (optimizer_type) {
+  case OptimizerType::kGenetic:
+    optimizer_.reset(new GeneticOptimizer(config_.copy_to_next_generation,
+      config_.selection_standard_deviation, config_.population_size,
+      config_.mutation_rate));
+    break;
+  case OptimizerType::kCmaEs:
+    optimizer_.reset(new CmaEsOptimizer(kCmaEsInitialStepSize));
+    break;
+  case OptimizerType::kAntitheticEs:
+    optimizer_.reset(new AntitheticEsOptimizer(kEsNoiseStandardDeviation,
+      kEsLearningRate));
+    break;
+  }
+  optimizer_type_ = optimizer_type;
+  GenerateRandom();
+}
+
+void LearningModel::SetSearchMode(SearchMode search_mode) {
+  search_mode_ = search_mode;
+  novelty_archive_.Clear();
+  elite_map_.Clear();
+}
+
+void LearningModel::SetCheckpointEpisodes(int checkpoint_count) {
+  checkpoint_count_ = std::max(checkpoint_count, 0);
+}
+
+int LearningModel::GetCheckpointCount() const {
+  return checkpoint_count_;
+}
+
+void LearningModel::SetDeterministicPhysics(bool deterministic_physics) {
+  this->deterministic_physics_ = deterministic_physics;
+}
+
+void LearningModel::SetDecisionInterval(int decision_interval) {
+  decision_interval_ = std::max(decision_interval, 1);
+}
+
+int LearningModel::GetDecisionInterval() const {
+  return decision_interval_;
+}
+
+void LearningModel::SetQuantizedInference(bool quantized_inference) {
+  quantized_inference_ = quantized_inference;
+}
+
+bool LearningModel::IsQuantizedInference() const {
+  return quantized_inference_;
+}
+
+void LearningModel::SetInteractingCars(bool interacting_cars) {
+  interacting_cars_ = interacting_cars;
+}
+
+bool LearningModel::IsInteractingCars() const {
+  return interacting_cars_;
+}
+
+void LearningModel::SetUserCar(Car* user_car) {
+  user_car_ = user_car;
+}
+
+bool LearningModel::IsDeterministicPhysics() const {
+  return deterministic_physics_;
+}
+
+void LearningModel::SetReplayDirectory(string replay_directory) {
+  this->replay_directory_ = replay_directory;
+  if (!replay_directory_.empty()) {
+    ofDirectory::createDirectory(replay_directory_, false, true);
+    SetDeterministicPhysics(true);
+  }
+}
+
+string LearningModel::GetLatestReplayPath() {
+  CollectChampionReplay(false);
+  return latest_replay_path_;
+}
+
+bool LearningModel::IsCurrentTrack(string track_folder) const {
+  return GetNormalizedFolder(track_folder)
+    == GetNormalizedFolder(track_folder_);
+}
+
+void LearningModel::SetGenerationLog(string path, int top_count) {
+  generation_log_.reset();
+  generation_log_top_count_ = std::max(top_count, 0);
+  if (!path.empty()) {
+    generation_log_.reset(new GenerationLogWriter(path));
+    if (!generation_log_->IsOpen()) {
+      ofLogError() << "Could not open generation log " << path;
+      generation_log_.reset();
+    }
+  }
+}
+
+bool LearningModel::IsLoggingGenerations() const {
+  return generation_log_ != nullptr;
+}
+
+SearchMode LearningModel::GetSearchMode() const {
+  return search_mode_;
+}
+
+Optimizer* LearningModel::GetOptimizer() {
+  return optimizer_.get();
+}
+
+OptimizerType LearningModel::GetOptimizerType() const {
+  return optimizer_type_;
+}
+
+void LearningModel::PopulateFromGenomes(int first_id) {
+  CancelTrackEvaluations();
+
+  // The finishing generation's networks are overwritten with the new
+  // genomes rather than freed and reallocated
+  int genome_count = offspring_genomes_.GetGenomeCount();
+  networks_.resize(genome_count);
+
+  population_.clear();
+  population_.reserve(genome_count);
+  generation_deterministic_physics_ = deterministic_physics_;
+  generation_decision_interval_ = decision_interval_;
+  generation_quantized_inference_ = quantized_inference_;
+  quantized_networks_.assign(
+    generation_quantized_inference_ ? genome_count : 0, QuantizedNetwork());
+
+  for (int i = 0; i < genome_count; i++) {
+    if (!networks_[i]) {
+      networks_[i].reset(new NeuralNetwork(architecture_));
+    }
+    NeuralNetwork* network = networks_[i].get();
+    offspring_genomes_.WriteNetwork(i, network);
+
+    // Population is drawn by PopulationRenderer, so Cars need no image
+    population_.push_back(Car(track_, first_id + i, network));
+    population_.back().SetDeterministic(generation_deterministic_physics_);
+    population_.back().SetDecisionInterval(generation_decision_interval_);
+    if (generation_quantized_inference_
+      && quantized_networks_[i].Quantize(network)) {
+      population_.back().SetQuantizedNetwork(&quantized_networks_[i]);
+    }
+  }
+}
+
+void LearningModel::RecordChampionReplay() {
+  CollectChampionReplay(true);
+
+  // The champion's network is overwritten by the next generation, so the
+  // worker drives a copy
+  Car* champion = &population_[leaderboard_.GetLeader().index];
+  std::shared_ptr<NeuralNetwork> network(new NeuralNetwork(architecture_));
+  network->get_multilayer_perceptron_pointer()->set_parameters(
+    champion->GetNeuralNetworkPointer()->get_multilayer_perceptron_pointer()
+      ->get_parameters());
+
+  Track* track = track_;
+  string track_folder = track_folder_;
+  int max_frames = kMaxGenerationFrames;
+  int decision_interval = generation_decision_interval_;
+  bool quantized = generation_quantized_inference_;
+  int generation = generation_number_;
+  string path = replay_directory_ + "/generation-"
+    + std::to_string(generation_number_) + ".replay";
+  pending_replay_ = std::async(std::launch::async, [=]() {
+    Replay replay = ReplayFile::Record(track, track_folder, network.get(),
+      max_frames, decision_interval, quantized);
+    replay.generation = generation;
+    return ReplayFile::Write(replay, path) ? path : string();
+  });
+}
+
+void LearningModel::CollectChampionReplay(bool wait) {
+  if (!pending_replay_.valid() || (!wait && pending_replay_.wait_for(
+    std::chrono::seconds(0)) != std::future_status::ready)) {
+    return;
+  }
+
+  string path = pending_replay_.get();
+  if (!path.empty()) {
+    latest_replay_path_ = path;
+  }
+}
+
+void LearningModel::LogGeneration(const vector<float>& fitness) {
+  vector<int> order(fitness.size());
+  for (unsigned i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  int top_count = std::min<int>(generation_log_top_count_, order.size());
+  std::partial_sort(order.begin(), order.begin() + top_count, order.end(),
+    [&fitness](int a, int b) { return fitness[a] > fitness[b]; });
+
+  GenerationRecord record;
+  record.generation = generation_number_;
+  record.top_fitness = *std::max_element(fitness.begin(), fitness.end());
+  record.mean_fitness = std::accumulate(fitness.begin(), fitness.end(), 0.0f)
+    / fitness.size();
+  record.disabled_count = disabled_count_;
+  record.frame_count = generation_frame_count_;
+  record.genome_size = genome_size_;
+  record.top_genomes.reserve(top_count * genome_size_);
+  for (int k = 0; k < top_count; k++) {
+    record.top_fitnesses.push_back(fitness[order[k]]);
+    const double* genome = parent_genomes_.GetGenome(order[k]);
+    record.top_genomes.insert(record.top_genomes.end(), genome,
+      genome + genome_size_);
+  }
+
+  generation_log_->Append(std::move(record));
+}
+
+vector<BehaviorDescriptor> LearningModel::GetBehaviors() const {
+  vector<BehaviorDescriptor> behaviors;
+  behaviors.reserve(population_.size());
+  for (const Car &car : population_) {
+    behaviors.push_back(BehaviorDescriptor(car.GetX(), car.GetY(),
+      car.GetAverageSpeed()));
+  }
+  return behaviors;
+}
+
+void LearningModel::ProduceMapElitesOffspring() {
+  offspring_genomes_.Resize(population_size_, genome_size_);
+  if (elite_map_.GetSize() == 0) {
+    map_elites_variation_.Randomize(&offspring_genomes_);
+    return;
+  }
+
+  FastRandom& random_engine = map_elites_variation_.GetRandomEngine();
+  for (int i = 0; i < population_size_; i++) {
+    map_elites_variation_.Recombine(elite_map_.Sample(random_engine),
+      elite_map_.Sample(random_engine), offspring_genomes_.GetGenome(i),
+      genome_size_);
+  }
+}
+
+void LearningModel::LaunchTrackEvaluations() {
+  if ((evaluation_tracks_.empty() && generation_checkpoint_count_ == 0)
+    || population_.empty()) {
+    return;
+  }
+
+  vector<uint64_t> genome_hashes;
+  for (Car &car : population_) {
+    genome_hashes.push_back(
+      FitnessCache::HashGenome(car.GetNeuralNetworkPointer()));
+  }
+
+  // The current track may also be an evaluation track after switching to
+  // it, and is already driven by the population itself
+  string current_folder = GetNormalizedFolder(track_folder_);
+  for (unsigned t = 0; t < evaluation_tracks_.size(); t++) {
+    if (GetNormalizedFolder(evaluation_track_folders_[t]) == current_folder) {
+      continue;
+    }
+    pending_evaluations_.push_back(LaunchEvaluation(
+      evaluation_tracks_[t].get(), 0,
+      GetFitnessContext(evaluation_track_folders_[t], 0), genome_hashes));
+    LaunchCheckpointEvaluations(evaluation_tracks_[t].get(),
+      evaluation_track_folders_[t], genome_hashes, &pending_evaluations_);
+  }
+
+  LaunchCheckpointEvaluations(track_, track_folder_, genome_hashes,
+    &pending_checkpoint_evaluations_);
+}
+
+void LearningModel::LaunchCheckpointEvaluations(Track* track,
+  string track_folder, const vector<uint64_t>& genome_hashes,
+  vector<PendingEvaluation>* evaluations) {
+
+  // Each track is also driven from its start, so checkpoints split the rest
+  // of the path evenly
+  int segment_count = track->GetSegmentCount();
+  int checkpoint_count = std::min(generation_checkpoint_count_,
+    segment_count - 1);
+  for (int c = 1; c <= checkpoint_count; c++) {
+    int segment = c * segment_count / (checkpoint_count + 1);
+    evaluations->push_back(LaunchEvaluation(track, segment,
+      GetFitnessContext(track_folder, segment), genome_hashes));
+  }
+}
+
+LearningModel::PendingEvaluation LearningModel::LaunchEvaluation(
+  Track* track, int start_segment, uint64_t context,
+  const vector<uint64_t>& genome_hashes) {
+
+  PendingEvaluation evaluation;
+  evaluation.track = track;
+  evaluation.start_segment = start_segment;
+  evaluation.context = context;
+  evaluation.fitnesses.resize(population_.size());
+  vector<NeuralNetwork*> networks;
+  for (unsigned i = 0; i < population_.size(); i++) {
+    if (use_fitness_cache_ && fitness_cache_.Lookup(genome_hashes[i],
+      context, &evaluation.fitnesses[i])) {
+      continue;
+    }
+    evaluation.evaluated_indices.push_back(i);
+    networks.push_back(population_[i].GetNeuralNetworkPointer());
+  }
+
+  TrackEvaluator evaluator(track, GetGenerationFrameLimit());
+  evaluator.SetDeterministicPhysics(generation_deterministic_physics_);
+  evaluator.SetDecisionInterval(generation_decision_interval_);
+  evaluator.SetQuantizedInference(generation_quantized_inference_);
+  evaluator.SetStartSegment(start_segment);
+  evaluation.stop = std::make_shared<std::atomic<bool>>(false);
+  std::shared_ptr<std::atomic<bool>> stop = evaluation.stop;
+  evaluation.result = std::async(std::launch::async,
+    [evaluator, networks, stop]() {
+      return evaluator.Evaluate(networks, stop.get());
+    });
+  return evaluation;
+}
+
+vector<float> LearningModel::CollectEvaluation(
+  PendingEvaluation& evaluation) {
+
+  vector<float> evaluated_fitness = evaluation.result.get();
+  for (unsigned j = 0; j < evaluated_fitness.size(); j++) {
+    int index = evaluation.evaluated_indices[j];
+    evaluation.fitnesses[index] = evaluated_fitness[j];
+    if (index < (int)population_.size()) {
+      fitness_cache_.Store(FitnessCache::HashGenome(
+        population_[index].GetNeuralNetworkPointer()), evaluation.context,
+        evaluated_fitness[j]);
+    }
+  }
+  evaluation.fitnesses.resize(population_.size());
+  return evaluation.fitnesses;
+}
+
+void LearningModel::ApplyTrackEvaluations() {
+  if (pending_evaluations_.empty()
+    && pending_checkpoint_evaluations_.empty()) {
+    return;
+  }
+
+  vector<float> total_fitness(population_.size());
+  for (unsigned i = 0; i < population_.size(); i++) {
+    total_fitness[i] = population_[i].GetFitness();
+  }
+
+  for (PendingEvaluation &evaluation : pending_checkpoint_evaluations_) {
+    vector<float> progress = CollectEvaluation(evaluation);
+    for (unsigned i = 0; i < population_.size(); i++) {
+      total_fitness[i] += progress[i];
+    }
+  }
+
+  // Every track is driven from its start and from the same number of
+  // checkpoints, so each contributes the same kind of sum. Progress on each
+  // track is converted to the current track's length so long tracks do not
+  // dominate the average.
+  int track_count = 1;
+  for (PendingEvaluation &evaluation : pending_evaluations_) {
+    vector<float> fitnesses = CollectEvaluation(evaluation);
+    float length_ratio = track_->GetTrackLength()
+      / evaluation.track->GetTrackLength();
+    for (unsigned i = 0; i < population_.size(); i++) {
+      total_fitness[i] += fitnesses[i] * length_ratio;
+    }
+    if (evaluation.start_segment == 0) {
+      track_count++;
+    }
+  }
+
+  for (unsigned i = 0; i < population_.size(); i++) {
+    population_[i].SetFitness(total_fitness[i] / track_count);
+  }
+  pending_evaluations_.clear();
+  pending_checkpoint_evaluations_.clear();
+}
+
+void LearningModel::CancelTrackEvaluations() {
+  // Stop every run before waiting on any, so they wind down together
+  for (PendingEvaluation &evaluation : pending_evaluations_) {
+    *evaluation.stop = true;
+  }
+  for (PendingEvaluation &evaluation : pending_checkpoint_evaluations_) {
+    *evaluation.stop = true;
+  }
+  for (PendingEvaluation &evaluation : pending_evaluations_) {
+    evaluation.result.wait();
+  }
+  for (PendingEvaluation &evaluation : pending_checkpoint_evaluations_) {
+    evaluation.result.wait();
+  }
+  pending_evaluations_.clear();
+  pending_checkpoint_evaluations_.clear();
+}
+
+string LearningModel::GetNormalizedFolder(string folder) const {
+  return ofFilePath::removeTrailingSlash(
+    ofFilePath::getAbsolutePath(folder, false));
+}
+
+int LearningModel::GetGenerationFrameLimit() const {
+  return generation_checkpoint_count_ > 0 ? kCheckpointEpisodeFrames
+    : kMaxGenerationFrames;
+}
+
+uint64_t LearningModel::GetFitnessContext(string track_folder,
+  int start_segment) const {
+  return FitnessCache::HashContext(track_folder, start_segment,
+    GetGenerationFrameLimit(), generation_deterministic_physics_,
+    interacting_cars_, generation_quantized_inference_,
+    generation_decision_interval_);
+}
+
+void LearningModel::StoreEvaluatedFitness() {
+  if (!use_fitness_cache_ || !auto_advance_generation || interacting_cars_) {
+    return;
+  }
+
+  uint64_t context = GetFitnessContext(track_folder_, 0);
+  if (context != generation_context_) {
+    return;
+  }
+
+  // Cars still driving when the generation was cut short have not earned
+  // their final fitness
+  for (Car &car : population_) {
+    if (car.IsDisabled()
+      || generation_frame_count_ >= GetGenerationFrameLimit()) {
+      fitness_cache_.Store(
+        FitnessCache::HashGenome(car.GetNeuralNetworkPointer()), context,
+        car.GetFitness());
+    }
+  }
+}
+
+void LearningModel::RebuildLeaderboard() {
+  leaderboard_.Reset(population_.size());
+  for (unsigned i = 0; i < population_.size(); i++) {
+    leaderboard_.Update(i, population_[i].GetFitness());
+  }
+}
 
-  Vector<Vector<double>> new_params;
+void LearningModel::ApplyCachedFitness() {
+  // Cached Cars never leave the start, so their behavior would be wrong
+  if (!use_fitness_cache_ || !auto_advance_generation || interacting_cars_
+    || search_mode_ != SearchMode::kFitness) {
+    return;
+  }
 
-  Vector<Vector<double>> first_params =
-    first->get_multilayer_perceptron_pointer()->get_layers_parameters();
-  Vector<Vector<double>> second_params =
-    second->get_multilayer_perceptron_pointer()->get_layers_parameters();
-  // Simple algorithm, likely to change.
-  for (unsigned layer = 0; layer < first_params.size(); layer++) {
-    new_params.push_back(Vector<double>(first_params[layer].size()));
-    for (unsigned node = 0; node < first_params[layer].size(); node++) {
-      new_params[layer][node] =
-        (first_params[layer][node] + second_params[layer][node]) / 2;
+  uint64_t context = GetFitnessContext(track_folder_, 0);
+  for (Car &car : population_) {
+    float fitness;
+    if (fitness_cache_.Lookup(
+      FitnessCache::HashGenome(car.GetNeuralNetworkPointer()), context,
+      &fitness)) {
+      car.SetFitness(fitness);
+      car.Disable();
+      disabled_count_++;
     }
   }
+}
+
+bool LearningModel::IsInStartGrace(const Car& car) const {
+  vector<float> start = track_->GetStartPosition();
+  return pow(car.GetX() - start[0], 2) + pow(car.GetY() - start[1], 2)
+    < pow(kStartGraceDistance, 2);
+}
 
-  MultilayerPerceptron recombined_perceptrons(architecture_);
-  recombined_perceptrons.set_layers_parameters(new_params);
-  recombined_perceptrons.perturbate_parameters(kMutationRate);
-  
-  return new NeuralNetwork(recombined_perceptrons);
+Car* LearningModel::GetHashedCar(int id) {
+  return id < 0 ? user_car_ : &population_[id];
 }
 
-void LearningModel::DeleteOldGeneration() {
+void LearningModel::RebuildCarHash() {
+  hashed_cars_.clear();
   for (unsigned i = 0; i < population_.size(); i++) {
-    delete population_[i].GetNeuralNetworkPointer();
+    if (!population_[i].IsDisabled() && !IsInStartGrace(population_[i])) {
+      hashed_cars_.push_back(HashedPoint(i, population_[i].GetX(),
+        population_[i].GetY()));
+    }
+  }
+  if (user_car_ != nullptr && !user_car_->IsDisabled()
+    && !IsInStartGrace(*user_car_)) {
+    hashed_cars_.push_back(HashedPoint(-1, user_car_->GetX(),
+      user_car_->GetY()));
+  }
+
+  car_hash_.Build(hashed_cars_, track_->background_.getWidth(),
+    track_->background_.getHeight());
+}
+
+const vector<const Car*>& LearningModel::FindNearbyCars(const Car& car) {
+  nearby_cars_.clear();
+  if (IsInStartGrace(car)) {
+    return nearby_cars_;
+  }
+
+  nearby_ids_.clear();
+  car_hash_.FindNear(car.GetX(), car.GetY(), kCarSensorRange, &nearby_ids_);
+  for (int id : nearby_ids_) {
+    const Car* other = GetHashedCar(id);
+    if (other != &car) {
+      nearby_cars_.push_back(other);
+    }
+  }
+  return nearby_cars_;
+}
+
+void LearningModel::ResolveCarCollisions() {
+  for (const HashedPoint& point : hashed_cars_) {
+    Car* car = GetHashedCar(point.id);
+    nearby_ids_.clear();
+    car_hash_.FindNear(point.x, point.y, 2 * car->GetBodyRadius(),
+      &nearby_ids_);
+    if (nearby_ids_.size() < 2) {
+      continue;
+    }
+
+    // Every Car found is touching this one, so all of them crash
+    for (int id : nearby_ids_) {
+      Car* crashed = GetHashedCar(id);
+      if (crashed->IsDisabled()) {
+        continue;
+      }
+      crashed->Disable();
+      if (id >= 0) {
+        disabled_count_++;
+        leaderboard_.Update(id, crashed->GetFitness());
+      }
+    }
   }
 }
\ No newline at end of file
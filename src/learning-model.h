@@ -1,10 +1,32 @@
 #pragma once
 
+#include <future>
+#include <memory>
 #include "car.h"
+#include "track-evaluator.h"
+#include "fitness-cache.h"
+#include "genetic-optimizer.h"
+#include "evolution-strategies.h"
+#include "behavior-archive.h"
+#include "replay.h"
+#include "generation-log.h"
+#include "leaderboard.h"
+#include "spatial-hash.h"
+#include "training-config.h"
 #include "opennn.h"
 
 using namespace OpenNN;
 
+// What the population is selected for
+enum class SearchMode {
+  // Progress along the track
+  kFitness,
+  // Distance of each Car's behavior from previously seen behaviors
+  kNovelty,
+  // Progress, kept separately for each region of behavior space (MAP-Elites)
+  kMapElites
+};
+
 class LearningModel {
 
 public:
@@ -15,17 +37,74 @@ public:
   // Construct LearningModel on a Track
   LearningModel(string assets_dir, int track_number);
 
+  // Construct LearningModel with hyperparameters from config on a Track
+  // loaded elsewhere. The Track is only read, so many LearningModels can
+  // share it across threads, and it is not deleted when the model changes
+  // track.
+  LearningModel(Track* shared_track, string track_folder,
+    TrainingConfig config);
+
+  // Waits for background evaluations, then frees the population's
+  // NeuralNetworks and the Tracks this LearningModel loaded
+  ~LearningModel();
+
+  // LearningModels own their Cars' NeuralNetworks, so they can be moved but
+  // not copied
+  LearningModel(LearningModel&& other) = default;
+  LearningModel& operator=(LearningModel&& other) = default;
+  LearningModel(const LearningModel& other) = delete;
+  LearningModel& operator=(const LearningModel& other) = delete;
+
   // Get pointer to LearningModel's current Track
   Track* GetTrack() const;
 
   // Start next generation on new track
   void SetTrack(string track_folder);
 
+  // Starts loading a track on a worker thread. Training continues on the
+  // current Track until FinishTrackLoad switches to it. If a load is already
+  // running, the folder is queued and loaded once it finishes, replacing the
+  // earlier request.
+  void LoadTrackAsync(string track_folder);
+
+  // Returns true if a track started by LoadTrackAsync has not been switched
+  // to yet
+  bool IsTrackLoading() const;
+
+  // If the track started by LoadTrackAsync has finished loading, switches to
+  // it as SetTrack does and returns true. Cars and Track pointers obtained
+  // before the switch are invalid afterwards.
+  bool FinishTrackLoad();
+
+  // Sets additional tracks every generation is evaluated on in parallel with
+  // the current Track. Each Car's fitness becomes its average progress over
+  // all tracks, scaled to the current Track's length. With checkpoint
+  // episodes, a track's progress is the sum of the runs from its start and
+  // from each of its checkpoints. A folder matching the current Track is
+  // skipped, also after switching track. Pass an empty list to train on one
+  // track.
+  void SetEvaluationTracks(vector<string> track_folders);
+
+  // Starts loading evaluation tracks on a worker thread. Generations keep
+  // their current evaluation tracks until FinishEvaluationTrackLoad switches
+  // to the new ones. If a load is already running, the folders are queued
+  // and loaded once it finishes, replacing the earlier request.
+  void LoadEvaluationTracksAsync(vector<string> track_folders);
+
+  // If the tracks started by LoadEvaluationTracksAsync have finished
+  // loading, switches to them as SetEvaluationTracks does and returns true
+  bool FinishEvaluationTrackLoad();
+
   // Set to false to prevent LearningModel from automatically calling
-  // StartNextGeneration at kMaxGenerationFrames or when all Cars are disabled.
+  // StartNextGeneration at the generation frame limit or when all Cars are
+  // disabled.
   void SetAutoAdvanceGeneration(bool auto_advance_generation);
 
-  // Generation kDefaultPopulationSize Cars with random NeuralNetworks
+  // Set to false to drive every Car each generation even if its fitness on
+  // the track is already known
+  void SetFitnessCacheEnabled(bool use_fitness_cache);
+
+  // Generation config_.population_size Cars with random NeuralNetworks
   void GenerateRandom();
 
   // Calculate next inputs and call FrameUpdate on each Car in the population
@@ -37,9 +116,19 @@ public:
   // Returns generation number of cars in this learning model
   int GetGenerationNumber() const;
 
-  // Returns fitness of most-fit Car in population
+  // Returns fitness of most-fit Car in population. Read from the
+  // leaderboard, so it is cheap enough to call every frame.
   float GetTopFitness() const;
 
+  // Returns fitness of the most fit Car of the last finished generation, or 0
+  // before any generation has finished
+  float GetLastGenerationTopFitness() const;
+
+  // Returns population index and fitness of up to count most-fit Cars, most
+  // fit first. Driving Cars' entries lag by up to kLeaderboardUpdateFrequency
+  // frames.
+  vector<LeaderboardEntry> GetLeaderboard(int count) const;
+
   // Return pointer to population
   vector<Car>* GetCars();
 
@@ -47,31 +136,138 @@ public:
   // next generation of Cars
   void StartNextGeneration();
 
-  // Reduces population_size to kCopyToNextGeneration. No learning will occur
+  // Reduces population_size to config_.copy_to_next_generation. No learning
+  // will occur
   void SetPopulationSize(int new_size);
 
+  // Replaces the optimizer evolving the population and restarts from a
+  // random generation
+  void SetOptimizer(OptimizerType optimizer_type);
+
+  // Returns optimizer that produces each generation's genomes
+  Optimizer* GetOptimizer();
+
+  // Returns type of the current optimizer
+  OptimizerType GetOptimizerType() const;
+
+  // Changes what the population is selected for. Clears behavior archives.
+  void SetSearchMode(SearchMode search_mode);
+
+  // Returns what the population is selected for
+  SearchMode GetSearchMode() const;
+
+  // Makes each generation from the next on also be driven from
+  // checkpoint_count checkpoints spread evenly along the track path, facing
+  // along it, on background threads. Evaluation tracks are driven from
+  // their own checkpoints too. Progress from each checkpoint adds to
+  // fitness, and generations last only kCheckpointEpisodeFrames frames, so
+  // later corners are trained without driving the whole lap each time. Pass
+  // 0 to drive only from the start for up to kMaxGenerationFrames frames.
+  void SetCheckpointEpisodes(int checkpoint_count);
+
+  // Returns number of checkpoints Cars are also driven from
+  int GetCheckpointCount() const;
+
+  // Makes Cars created from the next generation on use deterministic
+  // fixed-point physics
+  void SetDeterministicPhysics(bool deterministic_physics);
+
+  // Returns true if new Cars use deterministic physics
+  bool IsDeterministicPhysics() const;
+
+  // Makes Cars created from the next generation on recalculate their inputs
+  // every decision_interval frames, holding them in between
+  void SetDecisionInterval(int decision_interval);
+
+  // Returns number of frames Cars hold their inputs for
+  int GetDecisionInterval() const;
+
+  // Makes Cars created from the next generation on drive with int8
+  // quantized copies of their networks
+  void SetQuantizedInference(bool quantized_inference);
+
+  // Returns true if new Cars use quantized inference
+  bool IsQuantizedInference() const;
+
+  // Makes Cars collide with each other and see each other with their ray
+  // sensors. Cars near the start line ignore each other so the population
+  // can leave it. Fitness is not cached while Cars interact, since it
+  // depends on the rest of the population.
+  void SetInteractingCars(bool interacting_cars);
+
+  // Returns true if Cars collide with and sense each other
+  bool IsInteractingCars() const;
+
+  // Sets a Car driven outside the model, such as the user's, that
+  // population Cars collide with and sense when Cars interact. Pass nullptr
+  // for none.
+  void SetUserCar(Car* user_car);
+
+  // Records a replay of each generation's most fit Car to a directory.
+  // Enables deterministic physics so replays match what was driven. Pass an
+  // empty string to stop recording.
+  void SetReplayDirectory(string replay_directory);
+
+  // Returns path of the most recently written replay, or an empty string.
+  // Replays are recorded on a worker thread, so the replay of the
+  // generation that just finished may not be written yet.
+  string GetLatestReplayPath();
+
+  // Returns true if track_folder names the folder the current Track was
+  // loaded from. Replays only play back on the track they were recorded on.
+  bool IsCurrentTrack(string track_folder) const;
+
+  // Streams statistics and the top_count most fit genomes of each finished
+  // generation to a log file. Pass an empty path to stop logging.
+  void SetGenerationLog(string path, int top_count);
+
+  // Returns true if generations are being logged
+  bool IsLoggingGenerations() const;
+
 private:
 
-  // Number of Cars in each generation
-  int kDefaultPopulationSize = 50;
+  // Population size, genetic optimizer settings and network architecture
+  TrainingConfig config_;
+
+  // Initial step size of CMA-ES sampling distribution
+  double kCmaEsInitialStepSize = 0.5;
+
+  // Sampling noise and Adam learning rate of antithetic ES
+  double kEsNoiseStandardDeviation = 0.1;
+  double kEsLearningRate = 0.03;
+
+  // Width in pixels of the grid cells indexing novelty archive behaviors
+  float kNoveltyCellSize = 32;
 
-  // Standard deviation of Car rankings chosen as parents for next generation's
-  // offspring. Should be no more than kDefaultPopulationSize / 3
-  float kSelectionStandardDeviation = 6;
+  // Weight of average speed relative to position when comparing behaviors
+  float kNoveltySpeedWeight = 10;
 
-  // Number of top-performing Cars to directly copy to next generation
-  int kCopyToNextGeneration = 8;
+  // Number of nearest archived behaviors novelty is averaged over
+  int kNoveltyNeighbors = 15;
 
-  // Input to NeuralNetwork's perturbate_paramters method when mutating
-  // offspring. Higher is more mutation.
-  float kMutationRate = 1.0;
+  // Width of MAP-Elites cells in pixels and in average speed
+  float kEliteCellSize = 64;
+  float kEliteSpeedBinSize = 5;
 
   // Maximum number of frames to run a single generation
   int kMaxGenerationFrames = 6000;
 
-  // Architecture of Car NeuralNetworks. Each int represents the number of
-  // nodes in a layer
-  vector<int> kArchitecture = { 4, 3, 3, 2 };
+  // Number of frames in a generation and in each checkpoint episode when
+  // Cars are also driven from checkpoints
+  int kCheckpointEpisodeFrames = 1000;
+
+  // Width in pixels of the spatial hash cells used when Cars interact
+  float kCarHashCellSize = 64;
+
+  // Distance in pixels within which Cars' rays detect other Cars
+  float kCarSensorRange = 150;
+
+  // Cars closer than this many pixels to the start ignore other Cars
+  float kStartGraceDistance = 60;
+
+  // Number of frames between leaderboard updates of driving Cars. Cars are
+  // also updated on the frame they crash.
+  int kLeaderboardUpdateFrequency = 10;
 
   // Path of assets directory
   string assets_path;
@@ -80,30 +276,298 @@ private:
   // when constructing new Cars
   Track* track_ = nullptr;
 
+  // Fitness of the most fit Car when the last generation finished
+  float last_generation_top_fitness_ = 0;
+
+  // Folder track_ was loaded from
+  string track_folder_;
+
+  // Track being loaded by LoadTrackAsync and the folder it is loaded from
+  std::future<std::unique_ptr<Track>> pending_track_;
+  string pending_track_folder_;
+
+  // Folder requested while pending_track_ was loading. Empty if none.
+  string queued_track_folder_;
+
+  // Evaluation tracks being loaded by LoadEvaluationTracksAsync and the
+  // folders they are loaded from
+  std::future<vector<std::unique_ptr<Track>>> pending_evaluation_tracks_;
+  vector<string> pending_evaluation_track_folders_;
+
+  // Folders requested while pending_evaluation_tracks_ was loading
+  vector<string> queued_evaluation_track_folders_;
+  bool has_queued_evaluation_tracks_ = false;
+
+  // Evaluation of the current generation on one of evaluation_tracks_
+  struct PendingEvaluation {
+    // Fitness of each Car in population_. Only filled for cached genomes
+    // until the result is applied.
+    vector<float> fitnesses;
+
+    // Indices in population_ of the Cars driven on the worker thread
+    vector<int> evaluated_indices;
+
+    // Track the Cars are driven on
+    Track* track;
+
+    // Track path segment the Cars start at
+    int start_segment;
+
+    // Fitness cache context of the evaluation, fixed when it is launched
+    uint64_t context;
+
+    // Fitnesses of the evaluated Cars, computed on a background thread
+    // while the generation is driven
+    std::future<vector<float>> result;
+
+    // Set to end the background run early when its result is discarded
+    std::shared_ptr<std::atomic<bool>> stop;
+  };
+
+  // One PendingEvaluation per evaluation track
+  vector<PendingEvaluation> pending_evaluations_;
+
+  // Number of checkpoints on track_ each generation is also driven from
+  int checkpoint_count_ = 0;
+
+  // checkpoint_count_ when the current generation started. Fixes its frame
+  // limit and checkpoint evaluations until it finishes.
+  int generation_checkpoint_count_ = 0;
+
+  // One PendingEvaluation per checkpoint, driven on track_
+  vector<PendingEvaluation> pending_checkpoint_evaluations_;
+
+  // Champion replay being recorded and written on a worker thread. Holds
+  // the path written, or an empty string if writing failed.
+  std::future<string> pending_replay_;
+
+  // Tracks below are declared after the evaluations driving on them, so
+  // moving into a LearningModel waits for its evaluations before freeing
+  // its Tracks.
+
+  // Holds track_ unless it is shared with other LearningModels
+  std::unique_ptr<Track> owned_track_;
+
+  // Additional Tracks each generation is evaluated on headlessly. Shared
+  // read-only between evaluation threads.
+  vector<std::unique_ptr<Track>> evaluation_tracks_;
+
+  // Folders evaluation_tracks_ were loaded from
+  vector<string> evaluation_track_folders_;
+
+  // Fitnesses of genomes that have already been fully evaluated
+  FitnessCache fitness_cache_;
+
+  // Skip driving Cars whose fitness is in fitness_cache_
+  bool use_fitness_cache_ = true;
+
+  // Fitness context the current generation started in. Fitness is not
+  // cached if the track changed during the generation.
+  uint64_t generation_context_ = 0;
+
   // All Cars in the current generation's population
   vector<Car> population_;
 
+  // NeuralNetwork driving each Car in population_
+  vector<std::unique_ptr<NeuralNetwork>> networks_;
+
   // Current size of population
   int population_size_;
 
   // NeuralNetwork architecture with which to generate new Car NeuralNetworks
   Vector<unsigned> architecture_;
 
+  // Number of parameters in a NeuralNetwork with architecture_
+  int genome_size_ = 0;
+
+  // Produces offspring genomes each generation from the fitness of the last
+  std::unique_ptr<Optimizer> optimizer_;
+  OptimizerType optimizer_type_ = OptimizerType::kGenetic;
+
+  // What the population is selected for
+  SearchMode search_mode_ = SearchMode::kFitness;
+
+  // True if Cars use deterministic fixed-point physics
+  bool deterministic_physics_ = false;
+
+  // Directory champion replays are written to. Empty if not recording.
+  string replay_directory_;
+
+  // Path of the most recently written replay
+  string latest_replay_path_;
+
+  // Fitness ranking of population_, indexed by position in population_
+  Leaderboard leaderboard_;
+
+  // True if Cars collide with and sense each other
+  bool interacting_cars_ = false;
+
+  // Number of frames Cars hold their inputs for
+  int decision_interval_ = 1;
+
+  // True if Cars drive with quantized copies of their networks
+  bool quantized_inference_ = false;
+
+  // Physics, decision interval and inference mode the current generation's
+  // Cars were created with. Changes to the settings above apply from the
+  // next generation, so its evaluations and champion replay drive as the
+  // population does.
+  bool generation_deterministic_physics_ = false;
+  int generation_decision_interval_ = 1;
+  bool generation_quantized_inference_ = false;
+
+  // Quantized network of each Car in population_ when quantized_inference_
+  // is set
+  vector<QuantizedNetwork> quantized_networks_;
+
+  // Car driven outside the model that interacting Cars also meet
+  Car* user_car_ = nullptr;
+
+  // Positions of interacting Cars outside the start grace area. Ids are
+  // population indices, or -1 for user_car_.
+  SpatialHash car_hash_{ kCarHashCellSize };
+  vector<HashedPoint> hashed_cars_;
+
+  // Scratch space for spatial hash queries
+  vector<int> nearby_ids_;
+  vector<const Car*> nearby_cars_;
+
+  // Writes finished generations to the generation log. Null if not logging.
+  std::unique_ptr<GenerationLogWriter> generation_log_;
+
+  // Number of most fit genomes stored in each generation log record
+  int generation_log_top_count_ = 0;
+
+  // Behaviors of every Car evaluated in novelty search
+  NoveltyArchive novelty_archive_{ kNoveltyCellSize, kNoveltySpeedWeight };
+
+  // Most fit genome for each region of behavior space in MAP-Elites
+  EliteMap elite_map_{ kEliteCellSize, kEliteSpeedBinSize };
+
+  // Crosses over and mutates genomes sampled from elite_map_
+  SelectionEngine map_elites_variation_;
+
+  // Genomes of the finishing generation and of the generation replacing it.
+  // Kept between generations to avoid reallocating.
+  GenomePool parent_genomes_;
+  GenomePool offspring_genomes_;
+
   // Number of Cars that have been disabled/crashed in the current generation
   int disabled_count_ = 0;
 
   // Advance generation when generation_frame_count_ reaches
-  // kMaxGenerationFrames or all Cars are disabled
+  // GetGenerationFrameLimit() or all Cars are disabled
   bool auto_advance_generation = true;
 
   int generation_frame_count_ = 0;
   int generation_number_ = 1;
 
-  // Combine two NeuralNetworks into a rough average of the two with mutations
-  // according to the NeuralNetwork perturbate_parameters method.
-  NeuralNetwork* RecombineNeuralNetworks(NeuralNetwork* first,
-    NeuralNetwork* second);
+  // Replaces population with Cars driven by the genomes in offspring_genomes_.
+  // Cars are numbered consecutively from first_id. NeuralNetworks of the old
+  // population are reused.
+  void PopulateFromGenomes(int first_id);
+
+  // Starts recording a replay of the most fit Car of the current generation
+  // on a worker thread, with a copy of its network
+  void RecordChampionReplay();
+
+  // Sets latest_replay_path_ if the replay being recorded has been written.
+  // Waits for it first if wait is true.
+  void CollectChampionReplay(bool wait);
+
+  // Queues a generation log record of the current generation, given the
+  // fitness of each Car and their genomes in parent_genomes_
+  void LogGeneration(const vector<float>& fitness);
+
+  // Returns behavior of each Car in the population this generation
+  vector<BehaviorDescriptor> GetBehaviors() const;
+
+  // Fills offspring_genomes_ with mutated crossovers of genomes sampled from
+  // elite_map_
+  void ProduceMapElitesOffspring();
+
+  // Starts evaluating the current generation on each evaluation track and
+  // from each checkpoint of track_
+  void LaunchTrackEvaluations();
+
+  // Starts driving the current generation from each checkpoint of a Track,
+  // appending the evaluations to evaluations
+  void LaunchCheckpointEvaluations(Track* track, string track_folder,
+    const vector<uint64_t>& genome_hashes,
+    vector<PendingEvaluation>* evaluations);
+
+  // Starts driving the current generation on a Track from a path segment on
+  // a background thread. Genomes already cached in context are not driven.
+  PendingEvaluation LaunchEvaluation(Track* track, int start_segment,
+    uint64_t context, const vector<uint64_t>& genome_hashes);
+
+  // Waits for an evaluation, caches its results and returns fitness of
+  // every Car in the population
+  vector<float> CollectEvaluation(PendingEvaluation& evaluation);
+
+  // Waits for evaluation threads, adds checkpoint progress to fitness on
+  // track_ and averages that with the evaluation tracks' results into the
+  // fitness of each Car in the population
+  void ApplyTrackEvaluations();
+
+  // Stops evaluation threads early, waits for them to return and discards
+  // their results
+  void CancelTrackEvaluations();
+
+  // Returns absolute path of a folder without a trailing slash, for
+  // comparing folders
+  string GetNormalizedFolder(string folder) const;
+
+  // Returns number of frames after which the current generation ends
+  int GetGenerationFrameLimit() const;
+
+  // Returns hash of a Track, the path segment Cars start at and the current
+  // generation's simulation parameters
+  uint64_t GetFitnessContext(string track_folder, int start_segment) const;
+
+  // Caches fitness of every Car that finished its evaluation this generation
+  void StoreEvaluatedFitness();
+
+  // Gives Cars with cached fitness that fitness and disables them so they
+  // are not driven again
+  void ApplyCachedFitness();
+
+  // Ranks every Car in population_ on leaderboard_ from scratch
+  void RebuildLeaderboard();
+
+  // Returns true if a Car is close enough to the start to ignore other Cars
+  bool IsInStartGrace(const Car& car) const;
+
+  // Returns Car with an id used in car_hash_
+  Car* GetHashedCar(int id);
+
+  // Fills car_hash_ with the current positions of interacting Cars
+  void RebuildCarHash();
+
+  // Returns other Cars within sensor range of car. Valid until the next call.
+  const vector<const Car*>& FindNearbyCars(const Car& car);
+
+  // Disables every hashed Car touching another
+  void ResolveCarCollisions();
+
+  // Sets up population size, optimizer and architecture from config
+  void Configure(TrainingConfig config);
+
+  // Scores the current generation, records and logs it, and produces the
+  // next generation's genomes in offspring_genomes_
+  void FinishGeneration();
+
+  // Replaces the population with Cars driven by offspring_genomes_ on the
+  // current Track and starts evaluating them
+  void BeginGeneration();
+
+  // Replaces the evaluation tracks and relaunches the current generation's
+  // evaluations on them
+  void InstallEvaluationTracks(vector<std::unique_ptr<Track>> tracks,
+    vector<string> track_folders);
 
-  // Deletes NeuralNetwork pointers in each Car of the current generation
-  void DeleteOldGeneration();
+  // Makes track the current Track and starts a generation on it. The
+  // finishing generation is scored, recorded and logged on the old Track,
+  // which is deleted once its Cars have been replaced if it was owned.
+  void InstallTrack(std::unique_ptr<Track> track, string track_folder);
 };
\ No newline at end of file
@@ -1,8 +1,164 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "physics-regression.h"
+#include "offscreen-renderer.h"
+#include "quantized-network.h"
+#include "sweep-runner.h"
+#include "track-benchmark.h"
+#include <random>
+#include <thread>
+
+// Default number of simulation frames between recorded offscreen frames
+const int kDefaultOffscreenStride = 10;
+
+// Default number of generations trained while recording offscreen
+const int kDefaultOffscreenGenerations = 10;
+
+// Returns folder of every bundled track
+vector<string> GetBundledTrackFolders() {
+	return Track::GetBundledTrackFolders(
+		ofFilePath::getCurrentWorkingDirectory() + "/assets");
+}
+
+// Trains on the first bundled track without a window, rendering every
+// stride-th simulation frame to output until generations have finished
+int RunOffscreen(FrameOutput output, string destination, int stride,
+	int generations) {
+	string assets_path = ofFilePath::getCurrentWorkingDirectory() + "/assets";
+	LearningModel learning_model(assets_path, 1);
+	learning_model.GenerateRandom();
+
+	OffscreenRenderer renderer(learning_model.GetTrack(),
+		assets_path + "/car.png");
+	FrameWriter writer(output, destination);
+	if (!writer.IsOpen()) {
+		ofLogError() << "Could not open offscreen output " << destination;
+		return 1;
+	}
+	ofLogNotice() << "Recording " << renderer.GetWidth() << "x"
+		<< renderer.GetHeight() << " RGB frames every " << stride << " frames";
+
+	ofPixels frame;
+	for (int simulation_frame = 0;
+		learning_model.GetGenerationNumber() <= generations;
+		simulation_frame++) {
+		learning_model.FrameUpdate();
+		if (simulation_frame % stride == 0) {
+			renderer.Render(*learning_model.GetCars(), &frame);
+			writer.Write(frame);
+		}
+	}
+	return 0;
+}
+
+// Parses "key=value1,value2,..." into parameter. Returns false if the
+// argument has no '='.
+bool ParseSweepParameter(string argument, SweepParameter* parameter) {
+	size_t equals = argument.find('=');
+	if (equals == string::npos) {
+		return false;
+	}
+	parameter->key = argument.substr(0, equals);
+	parameter->values = ofSplitString(argument.substr(equals + 1), ",", true);
+	return true;
+}
+
+// Sweeps the hyperparameters given as arguments on the first bundled track,
+// trying random=N random combinations if given and every combination
+// otherwise. Prints a table of the best fitness each combination reached.
+int RunSweep(int max_generations, vector<string> arguments) {
+	int random_count = 0;
+	vector<SweepParameter> parameters;
+	for (string argument : arguments) {
+		SweepParameter parameter;
+		if (!ParseSweepParameter(argument, &parameter)) {
+			ofLogError() << "Expected key=value1,value2,... but got " << argument;
+			return 1;
+		}
+		if (parameter.key == "random") {
+			random_count = std::stoi(argument.substr(argument.find('=') + 1));
+		} else {
+			parameters.push_back(parameter);
+		}
+	}
+
+	SweepRunner runner(ofFilePath::getCurrentWorkingDirectory()
+		+ "/assets/track1", std::thread::hardware_concurrency());
+	bool added = random_count > 0
+		? runner.AddRandom(parameters, random_count, std::random_device()())
+		: runner.AddGrid(parameters);
+	if (!added) {
+		ofLogError() << "Unknown sweep parameter or malformed value";
+		return 1;
+	}
+	ofLogNotice() << "Sweeping " << runner.GetConfigCount() << " configs for up to "
+		<< max_generations << " generations";
+	runner.Run(max_generations);
+	runner.PrintResults();
+	return 0;
+}
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
+	// headless modes run without a window or GL context
+	string mode = argc > 1 ? argv[1] : "";
+	if (mode == "--verify-physics") {
+		ofInit();
+		return PhysicsRegression::VerifyTracks(GetBundledTrackFolders()) ? 0 : 1;
+	}
+	if (mode == "--update-physics-golden") {
+		ofInit();
+		PhysicsRegression::UpdateTracks(GetBundledTrackFolders());
+		return 0;
+	}
+	if (mode == "--verify-quantized") {
+		ofInit();
+		LearningModel learning_model(
+			ofFilePath::getCurrentWorkingDirectory() + "/assets", 1);
+		learning_model.GenerateRandom();
+		while (learning_model.GetGenerationNumber()
+			<= QuantizedValidation::kTrainingGenerations) {
+			learning_model.FrameUpdate();
+		}
+		vector<NeuralNetwork*> networks;
+		for (Car& car : *learning_model.GetCars()) {
+			networks.push_back(car.GetNeuralNetworkPointer());
+		}
+		return QuantizedValidation::VerifyTracks(GetBundledTrackFolders(),
+			networks) ? 0 : 1;
+	}
+	if ((mode == "--offscreen-frames" || mode == "--offscreen-pipe")
+		&& argc > 2) {
+		ofInit();
+		int stride = argc > 3 ? std::max(1, std::stoi(argv[3]))
+			: kDefaultOffscreenStride;
+		int generations = argc > 4 ? std::stoi(argv[4])
+			: kDefaultOffscreenGenerations;
+		return RunOffscreen(mode == "--offscreen-pipe" ? FrameOutput::kRawPipe
+			: FrameOutput::kImageSequence, argv[2], stride, generations);
+	}
+
+	if (mode == "--sweep" && argc > 2) {
+		ofInit();
+		return RunSweep(std::stoi(argv[2]), vector<string>(argv + 3, argv + argc));
+	}
+
+	if (mode == "--generate-track" && argc > 2) {
+		ofInit();
+		TrackShape shape;
+		if (argc > 3) shape.size = std::stoi(argv[3]);
+		if (argc > 4) shape.road_width = std::stoi(argv[4]);
+		if (argc > 5) shape.curvature = std::stof(argv[5]);
+		if (argc > 6) shape.checkpoint_count = std::stoi(argv[6]);
+		if (argc > 7) shape.seed = std::stoul(argv[7]);
+		return TrackGenerator::Generate(shape, argv[2]) ? 0 : 1;
+	}
+	if (mode == "--benchmark") {
+		ofInit();
+		return TrackBenchmark::Run(argc > 2 ? argv[2]
+			: ofFilePath::getCurrentWorkingDirectory() + "/benchmark") ? 0 : 1;
+	}
+
 	ofSetupOpenGL(1024,1024,OF_WINDOW);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
@@ -7,6 +7,7 @@ void ofApp::setup(){
   assets_path = string(buff) + "\\assets";
 
   forced_square_ttf_.load(assets_path + "/forced_square.ttf", 32);
+  population_renderer_.Setup(assets_path + "/car.png");
   updates_per_frame_ = kDefaultUpdatesPerFrame;
 
   learning_model_ = LearningModel(assets_path, 1);
@@ -17,37 +18,62 @@ void ofApp::setup(){
 
 //--------------------------------------------------------------
 void ofApp::update(){
+  FinishTrackLoad();
+  learning_model_.FinishEvaluationTrackLoad();
+  ApplyPendingResize();
+
   if (!menu_is_open_) {
-    for (int i = 0; i < updates_per_frame_; i++) {
-      learning_model_.FrameUpdate();
+    if (adaptive_speed_) {
+      RunAdaptiveUpdates();
+    } else {
+      for (int i = 0; i < updates_per_frame_; i++) {
+        learning_model_.FrameUpdate();
+      }
     }
     if (racing_mode_) {
       user_car_.FrameUpdate(user_inputs_);
     }
+    if (replay_player_.IsActive()) {
+      replay_player_.Advance(kReplayFramesPerDisplayFrame);
+    }
   }
 }
 
 //--------------------------------------------------------------
 void ofApp::draw() {
-  Track* track = learning_model_.GetTrack();
-  track->background_.draw(0, 0,
-    track->background_.getWidth() * track->GetScale(),
-    track->background_.getHeight() * track->GetScale());
+  learning_model_.GetTrack()->DrawBackground();
 
-  for (Car car : *learning_model_.GetCars()) {
-    DrawCar(&car);
-  }
+  population_renderer_.Draw(*learning_model_.GetCars(),
+    learning_model_.GetTrack()->GetScale());
 
   if (racing_mode_) {
     DrawCar(&user_car_);
   }
 
+  if (replay_player_.IsActive()) {
+    DrawCar(replay_player_.GetCar());
+  }
+
   if (menu_is_open_) {
     int height = 50;
 
     // tell user how many car updates per frame
     forced_square_ttf_.drawString("Current car updates per frame: "
-      + std::to_string(updates_per_frame_), 50, height);
+      + std::to_string(updates_per_frame_)
+      + (adaptive_speed_ ? " (adaptive)" : ""), 50, height);
+    height += 50;
+
+    forced_square_ttf_.drawString("Decision interval: "
+      + std::to_string(learning_model_.GetDecisionInterval()) + " frames",
+      50, height);
+    height += 50;
+
+    forced_square_ttf_.drawString("Optimizer: "
+      + learning_model_.GetOptimizer()->GetName(), 50, height);
+    height += 50;
+
+    forced_square_ttf_.drawString("Search mode: "
+      + kSearchModeNames[(int)learning_model_.GetSearchMode()], 50, height);
     height += 50;
 
     // render options
@@ -104,23 +130,76 @@ void ofApp::keyPressed(int key){
       ofFileDialogResult folder = ofSystemLoadDialog("Select track folder",
         true, assets_path);
       if (folder.bSuccess) {
-        learning_model_.SetTrack(folder.filePath);
-        user_car_ = Car(learning_model_.GetTrack(), -1, assets_path);
-        user_car_.ChangeImage(assets_path + "/car-recolored.png");
+        learning_model_.LoadTrackAsync(folder.filePath);
       }
     }
     if (key == 'r') {
       ToggleRaceMode(!racing_mode_);
     }
     if (key == 's') {
+      adaptive_speed_ = false;
       updates_per_frame_++;
     }
     if (key == 'a') {
+      adaptive_speed_ = false;
       updates_per_frame_--;
     }
+    if (key == 'i') {
+      learning_model_.SetInteractingCars(!learning_model_.IsInteractingCars());
+    }
+    if (key == 'h') {
+      int interval = learning_model_.GetDecisionInterval() * 2;
+      learning_model_.SetDecisionInterval(
+        interval > kMaxDecisionInterval ? 1 : interval);
+    }
+    if (key == 'e') {
+      learning_model_.SetCheckpointEpisodes(
+        learning_model_.GetCheckpointCount() > 0 ? 0 : kEpisodeCheckpoints);
+    }
+    if (key == 'k') {
+      learning_model_.SetQuantizedInference(
+        !learning_model_.IsQuantizedInference());
+    }
+    if (key == 'u') {
+      adaptive_speed_ = !adaptive_speed_ && !racing_mode_;
+    }
     if (key == 'q') {
       learning_model_.GenerateRandom();
     }
+    if (key == 't') {
+      ToggleMultiTrackMode(!multi_track_mode_);
+    }
+    if (key == 'o') {
+      switch (learning_model_.GetOptimizerType()) {
+      case OptimizerType::kGenetic:
+        learning_model_.SetOptimizer(OptimizerType::kCmaEs);
+        break;
+      case OptimizerType::kCmaEs:
+        learning_model_.SetOptimizer(OptimizerType::kAntitheticEs);
+        break;
+      case OptimizerType::kAntitheticEs:
+        learning_model_.SetOptimizer(OptimizerType::kGenetic);
+        break;
+      }
+    }
+    if (key == 'l') {
+      recording_champions_ = !recording_champions_;
+      learning_model_.SetReplayDirectory(recording_champions_
+        ? ofFilePath::getCurrentWorkingDirectory() + "/replays" : "");
+    }
+    if (key == 'p') {
+      PlayLatestReplay();
+    }
+    if (key == 'g') {
+      learning_model_.SetGenerationLog(learning_model_.IsLoggingGenerations()
+        ? "" : ofFilePath::getCurrentWorkingDirectory() + "/generations.glog",
+        kGenerationLogTopCount);
+    }
+    if (key == 'v') {
+      int next_mode = ((int)learning_model_.GetSearchMode() + 1)
+        % kSearchModeNames.size();
+      learning_model_.SetSearchMode((SearchMode)next_mode);
+    }
 
     updates_per_frame_ = CLAMP(updates_per_frame_, 1, kMaxUpdatesPerFrame);
   }
@@ -172,9 +251,8 @@ void ofApp::mouseExited(int x, int y){
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h){
   float min_dim = MIN(w, h);
-  float new_scale = min_dim / learning_model_.GetTrack()->background_.getWidth();
-  learning_model_.GetTrack()->SetScale(new_scale);
-  std::this_thread::sleep_for(std::chrono::milliseconds(kResizeDelayMs));
+  pending_scale_ = min_dim / learning_model_.GetTrack()->background_.getWidth();
+  last_resize_ms_ = ofGetElapsedTimeMillis();
 }
 
 //--------------------------------------------------------------
@@ -207,11 +285,16 @@ void ofApp::ToggleRaceMode(bool new_setting) {
   if (racing_mode_) {
     user_car_ = Car(learning_model_.GetTrack(), -1, assets_path);
     user_car_.ChangeImage(assets_path + "/car-recolored.png");
+    // Racing is only fair at one update per frame
+    adaptive_speed_ = false;
     updates_per_frame_ = 1;
+    learning_model_.SetUserCar(&user_car_);
     learning_model_.SetPopulationSize(5);
     learning_model_.SetAutoAdvanceGeneration(false);
   } else {
     user_car_.Disable();
+    learning_model_.SetUserCar(nullptr);
+    adaptive_speed_ = true;
     updates_per_frame_ = kDefaultUpdatesPerFrame;
     learning_model_.SetPopulationSize(-1);
     learning_model_.SetAutoAdvanceGeneration(true);
@@ -222,4 +305,66 @@ void ofApp::ResetUserCar() {
   if (racing_mode_) {
     user_car_.ResetPosition();
   }
+}
+
+void ofApp::ToggleMultiTrackMode(bool new_setting) {
+  multi_track_mode_ = new_setting;
+
+  learning_model_.LoadEvaluationTracksAsync(multi_track_mode_
+    ? Track::GetBundledTrackFolders(assets_path) : vector<string>());
+}
+
+void ofApp::PlayLatestReplay() {
+  Replay replay;
+  if (!ReplayFile::Read(learning_model_.GetLatestReplayPath(), &replay)) {
+    return;
+  }
+  if (!learning_model_.IsCurrentTrack(replay.track_folder)) {
+    ofLogWarning() << "Not playing replay recorded on "
+      << replay.track_folder << " on another track";
+    return;
+  }
+
+  Car replay_car(learning_model_.GetTrack(), -2, assets_path);
+  replay_player_.Start(replay, replay_car);
+}
+
+void ofApp::FinishTrackLoad() {
+  if (!learning_model_.FinishTrackLoad()) {
+    return;
+  }
+
+  replay_player_.Stop();
+  user_car_ = Car(learning_model_.GetTrack(), -1, assets_path);
+  user_car_.ChangeImage(assets_path + "/car-recolored.png");
+  ofSetBackgroundColor(learning_model_.GetTrack()->GetBackgroundColor());
+}
+
+void ofApp::ApplyPendingResize() {
+  if (pending_scale_ < 0
+    || ofGetElapsedTimeMillis() - last_resize_ms_ < (uint64_t)kResizeDelayMs) {
+    return;
+  }
+  learning_model_.GetTrack()->SetScale(pending_scale_);
+  pending_scale_ = -1;
+}
+
+void ofApp::RunAdaptiveUpdates() {
+  auto start = std::chrono::steady_clock::now();
+  float elapsed_seconds = 0;
+  int updates = 0;
+
+  // Stop before an update expected to overrun the budget. At least one
+  // update always runs so training never stalls.
+  do {
+    learning_model_.FrameUpdate();
+    updates++;
+    elapsed_seconds = std::chrono::duration<float>(
+      std::chrono::steady_clock::now() - start).count();
+  } while (updates < kMaxAdaptiveUpdatesPerFrame
+    && elapsed_seconds + seconds_per_update_ <= kFrameBudgetSeconds);
+
+  seconds_per_update_ += kUpdateTimeSmoothing
+    * (elapsed_seconds / updates - seconds_per_update_);
+  updates_per_frame_ = updates;
 }
\ No newline at end of file
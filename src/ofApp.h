@@ -6,6 +6,8 @@
 #include "car-inputs.h"
 #include "car.h"
 #include "learning-model.h"
+#include "replay.h"
+#include "population-renderer.h"
 
 class ofApp : public ofBaseApp{
 
@@ -29,7 +31,7 @@ public:
 
 private:
 
-  // Delay in ms between attempts to change track size as window resizes
+  // Time in ms the window must stop resizing before the track is rescaled
   const long kResizeDelayMs = 100;
 
   // Default number of times FrameUpdate is called in the app's LearningModel
@@ -38,9 +40,34 @@ private:
   // Maximum possible car updates per frame
   const int kMaxUpdatesPerFrame = 100;
 
+  // Time each display frame spends on simulation when speed is adaptive.
+  // Leaves room for drawing within a 60 Hz frame.
+  const float kFrameBudgetSeconds = 0.014f;
+
+  // Most simulation updates in one display frame when speed is adaptive
+  const int kMaxAdaptiveUpdatesPerFrame = 5000;
+
+  // Weight of the latest frame in the running time-per-update estimate
+  const float kUpdateTimeSmoothing = 0.2f;
+
+  // Replay frames played per display frame. Fixed, unlike the training
+  // speed, so a replay plays at the pace the user's car drives at.
+  const int kReplayFramesPerDisplayFrame = 1;
+
   // Input magnitude sent to the CarInputs controlling the user's car
   const float kMaxUserInput = 4.0;
 
+  // Largest number of frames Cars can hold their inputs for. H doubles the
+  // decision interval up to this, then returns to every frame.
+  const int kMaxDecisionInterval = 8;
+
+  // Number of checkpoints along the track Cars are also driven from when
+  // checkpoint episodes are on
+  const int kEpisodeCheckpoints = 4;
+
+  // Number of most fit genomes saved per generation in the generation log
+  const int kGenerationLogTopCount = 5;
+
   const string kMenuTip = "M: open menu";
 
   const string kResetCarTip = "N: reset car positions";
@@ -51,7 +78,25 @@ private:
     "R: Toggle Racing Mode",
     "S: Increase Simulation Speed",
     "A: Decrease Simulation Speed",
-    "Q: Reset Population"
+    "Q: Reset Population",
+    "T: Toggle Multi-Track Training",
+    "O: Change Optimizer",
+    "V: Change Search Mode",
+    "L: Toggle Champion Recording",
+    "P: Play Latest Champion Replay",
+    "G: Toggle Generation Log",
+    "U: Toggle Adaptive Simulation Speed",
+    "I: Toggle Car Collisions",
+    "K: Toggle Quantized Inference",
+    "H: Change Decision Interval",
+    "E: Toggle Checkpoint Episodes"
+  };
+
+  // Display names of each SearchMode in declaration order
+  const vector<string> kSearchModeNames = {
+    "Fitness",
+    "Novelty",
+    "MAP-Elites"
   };
 
   // Absolute path to project assets folder
@@ -63,9 +108,19 @@ private:
   // True if user-controlled Car is on track
   bool racing_mode_;
 
-  // Number of times to call FrameUpdate in this app's LearningModel
+  // True if generations are also evaluated on every bundled track
+  bool multi_track_mode_ = false;
+
+  // Number of times to call FrameUpdate in this app's LearningModel. Set
+  // each frame when speed is adaptive.
   int updates_per_frame_;
 
+  // True if updates_per_frame_ is chosen to fill kFrameBudgetSeconds
+  bool adaptive_speed_ = true;
+
+  // Running estimate of the time one LearningModel FrameUpdate takes
+  float seconds_per_update_ = 0;
+
   // Font used to write text to screen
   ofTrueTypeFont forced_square_ttf_;
 
@@ -78,6 +133,20 @@ private:
   // Car object controlled by user when racing_mode_ is true
   Car user_car_;
 
+  // True if each generation's champion is recorded to replay files
+  bool recording_champions_ = false;
+
+  // Plays back recorded champion runs alongside training
+  ReplayPlayer replay_player_;
+
+  // Track scale requested by the latest resize, and when it was requested.
+  // Negative if there is no resize waiting to be applied.
+  float pending_scale_ = -1;
+  uint64_t last_resize_ms_ = 0;
+
+  // Draws the LearningModel's population
+  PopulationRenderer population_renderer_;
+
   // Draws a single Car on the screen with correct position and rotation
   void DrawCar(Car* to_draw);
 
@@ -86,4 +155,20 @@ private:
 
   // Returns user's car to track's starting position
   void ResetUserCar();
+
+  // Turns evaluation on all bundled tracks on or off
+  void ToggleMultiTrackMode(bool new_setting);
+
+  // Starts playing the most recently recorded champion replay
+  void PlayLatestReplay();
+
+  // Switches to a track loaded in the background once it is ready and
+  // rebuilds everything that pointed at the old track
+  void FinishTrackLoad();
+
+  // Rescales the track to the window once resizing has settled
+  void ApplyPendingResize();
+
+  // Runs as many LearningModel updates as fit in kFrameBudgetSeconds
+  void RunAdaptiveUpdates();
 };
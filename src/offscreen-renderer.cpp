@@ -0,0 +1,191 @@
+#include "offscreen-renderer.h"
+#include "ofImage.h"
+#include "ofFileUtils.h"
+#include <cerrno>
+#include <cstring>
+
+// Mode to open the frame pipe with. POSIX popen rejects "b", but Windows
+// needs it to keep frames from being translated as text.
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+const char* kPipeMode = "wb";
+#else
+const char* kPipeMode = "w";
+#endif
+
+OffscreenRenderer::OffscreenRenderer(const Track* track,
+  string car_image_path) {
+  track_ = track;
+  background_ = track->background_.getPixels();
+  background_.setImageType(OF_IMAGE_COLOR);
+
+  if (ofLoadImage(car_sprite_, car_image_path)) {
+    car_sprite_.setImageType(OF_IMAGE_COLOR_ALPHA);
+  }
+}
+
+int OffscreenRenderer::GetWidth() const {
+  return background_.getWidth();
+}
+
+int OffscreenRenderer::GetHeight() const {
+  return background_.getHeight();
+}
+
+void OffscreenRenderer::Render(const vector<Car>& cars,
+  ofPixels* frame) const {
+  *frame = background_;
+  if (cars.empty()) {
+    return;
+  }
+
+  // Frames are in native track pixels, so undo the on-screen track scale
+  // included in Car::GetScale
+  float sprite_scale = cars[0].GetScale() / track_->GetScale();
+  for (const Car& car : cars) {
+    DrawCar(car, sprite_scale, frame);
+  }
+}
+
+void OffscreenRenderer::DrawCar(const Car& car, float sprite_scale,
+  ofPixels* frame) const {
+  bool has_sprite = car_sprite_.isAllocated();
+  float sprite_width = has_sprite ? car_sprite_.getWidth() : kFallbackCarWidth;
+  float sprite_height = has_sprite
+    ? car_sprite_.getHeight() : kFallbackCarHeight;
+  float half_width = sprite_width * sprite_scale / 2;
+  float half_height = sprite_height * sprite_scale / 2;
+  float radius = sqrt(half_width * half_width + half_height * half_height);
+
+  float center_x = car.GetX();
+  float center_y = car.GetY();
+  float c = cos(car.GetRotation());
+  float s = sin(car.GetRotation());
+
+  int min_x = std::max(0, (int)floor(center_x - radius));
+  int max_x = std::min((int)frame->getWidth() - 1,
+    (int)ceil(center_x + radius));
+  int min_y = std::max(0, (int)floor(center_y - radius));
+  int max_y = std::min((int)frame->getHeight() - 1,
+    (int)ceil(center_y + radius));
+
+  unsigned char* pixels = frame->getData();
+  int frame_width = frame->getWidth();
+  for (int y = min_y; y <= max_y; y++) {
+    for (int x = min_x; x <= max_x; x++) {
+      // Rotate the pixel center into the Car's frame
+      float dx = x + 0.5f - center_x;
+      float dy = y + 0.5f - center_y;
+      float along = c * dx + s * dy;
+      float across = -s * dx + c * dy;
+      if (fabs(along) >= half_width || fabs(across) >= half_height) {
+        continue;
+      }
+
+      unsigned char* pixel = pixels + 3 * (y * frame_width + x);
+      if (!has_sprite) {
+        pixel[0] = kFallbackCarColor.r;
+        pixel[1] = kFallbackCarColor.g;
+        pixel[2] = kFallbackCarColor.b;
+        continue;
+      }
+
+      int sprite_x = std::min((int)sprite_width - 1,
+        (int)((along + half_width) / sprite_scale));
+      int sprite_y = std::min((int)sprite_height - 1,
+        (int)((across + half_height) / sprite_scale));
+      const unsigned char* texel = car_sprite_.getData()
+        + 4 * (sprite_y * (int)sprite_width + sprite_x);
+      int alpha = texel[3];
+      for (int channel = 0; channel < 3; channel++) {
+        pixel[channel] = (texel[channel] * alpha
+          + pixel[channel] * (255 - alpha)) / 255;
+      }
+    }
+  }
+}
+
+FrameWriter::FrameWriter(FrameOutput output, string destination) {
+  output_ = output;
+  destination_ = destination;
+
+  if (output_ == FrameOutput::kRawPipe) {
+    pipe_ = popen(destination.c_str(), kPipeMode);
+    if (pipe_ == nullptr) {
+      ofLogError() << "Could not open pipe to " << destination << ": "
+        << strerror(errno);
+    }
+  } else {
+    ofDirectory::createDirectory(destination, false, true);
+  }
+
+  thread_ = std::thread(&FrameWriter::Run, this);
+}
+
+FrameWriter::~FrameWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  queue_changed_.notify_all();
+  thread_.join();
+
+  if (pipe_ != nullptr) {
+    pclose(pipe_);
+  }
+}
+
+bool FrameWriter::IsOpen() const {
+  return output_ == FrameOutput::kImageSequence
+    ? ofDirectory::doesDirectoryExist(destination_, false)
+    : pipe_ != nullptr;
+}
+
+void FrameWriter::Write(ofPixels frame) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_changed_.wait(lock,
+    [this]() { return queue_.size() < kMaxQueuedFrames; });
+  queue_.push_back(std::move(frame));
+  lock.unlock();
+  queue_changed_.notify_all();
+}
+
+int FrameWriter::GetFrameCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return frame_count_;
+}
+
+void FrameWriter::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queue_changed_.wait(lock,
+      [this]() { return stopping_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+
+    ofPixels frame = std::move(queue_.front());
+    queue_.pop_front();
+    int index = frame_count_;
+    lock.unlock();
+    queue_changed_.notify_all();
+
+    WriteFrame(frame, index);
+
+    lock.lock();
+    frame_count_++;
+  }
+}
+
+void FrameWriter::WriteFrame(const ofPixels& frame, int index) {
+  if (output_ == FrameOutput::kRawPipe) {
+    if (pipe_ != nullptr) {
+      fwrite(frame.getData(), 1, frame.size(), pipe_);
+    }
+    return;
+  }
+
+  string name = ofToString(index, 6, '0');
+  ofSaveImage(frame, destination_ + "/frame-" + name + ".png");
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "ofPixels.h"
+#include "car.h"
+
+// Rasterizes a Track and its Cars into memory on the CPU. Needs no window or
+// GL context, so progress can be recorded on headless machines.
+class OffscreenRenderer {
+
+public:
+
+  // Prepares to draw Cars on track with the sprite at car_image_path. Cars
+  // are drawn as rectangles if the sprite cannot be loaded.
+  OffscreenRenderer(const Track* track, string car_image_path);
+
+  // Returns size of rendered frames in pixels (the track's native size)
+  int GetWidth() const;
+  int GetHeight() const;
+
+  // Draws the track background and cars into frame as 8-bit RGB
+  void Render(const vector<Car>& cars, ofPixels* frame) const;
+
+private:
+
+  // Color of Cars when no sprite is loaded
+  ofColor kFallbackCarColor = ofColor(230, 40, 40);
+
+  // Dimensions of the fallback rectangle in sprite pixels, matching car.png
+  float kFallbackCarWidth = 174;
+  float kFallbackCarHeight = 84;
+
+  const Track* track_;
+
+  // Track background converted to RGB
+  ofPixels background_;
+
+  // Car sprite with alpha. Empty if it could not be loaded.
+  ofPixels car_sprite_;
+
+  // Draws one Car into frame, scaling its sprite by sprite_scale
+  void DrawCar(const Car& car, float sprite_scale, ofPixels* frame) const;
+};
+
+// Where a FrameWriter sends frames
+enum class FrameOutput {
+  // Numbered PNG files in a directory
+  kImageSequence,
+  // Raw RGB24 frames written to the standard input of a shell command,
+  // such as an ffmpeg invocation reading rawvideo from "-"
+  kRawPipe
+};
+
+// Encodes and writes frames on a background thread so rendering and
+// training are not held up by disk or the encoder
+class FrameWriter {
+
+public:
+
+  // Opens destination, a directory for kImageSequence or a shell command for
+  // kRawPipe
+  FrameWriter(FrameOutput output, string destination);
+
+  // Writes queued frames, then closes the destination
+  ~FrameWriter();
+
+  // Returns true if the destination could be opened
+  bool IsOpen() const;
+
+  // Queues a frame. Blocks while kMaxQueuedFrames are waiting, so no frame
+  // of a video is ever dropped.
+  void Write(ofPixels frame);
+
+  // Returns number of frames written so far
+  int GetFrameCount() const;
+
+private:
+
+  // Largest number of frames waiting to be written
+  unsigned kMaxQueuedFrames = 8;
+
+  FrameOutput output_;
+  string destination_;
+
+  // Standard input of the pipe command. Null for image sequences.
+  FILE* pipe_ = nullptr;
+
+  std::thread thread_;
+  mutable std::mutex mutex_;
+  std::condition_variable queue_changed_;
+  std::deque<ofPixels> queue_;
+  bool stopping_ = false;
+  int frame_count_ = 0;
+
+  // Background thread loop
+  void Run();
+
+  // Writes one frame to the destination
+  void WriteFrame(const ofPixels& frame, int index);
+};
\ No newline at end of file
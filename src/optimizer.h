@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include "genome-pool.h"
+
+using std::string;
+
+// Optimizer backends LearningModel can evolve its NeuralNetworks with
+enum class OptimizerType {
+  // Genetic algorithm with elitism, selection and crossover
+  kGenetic,
+  // Covariance matrix adaptation evolution strategy
+  kCmaEs,
+  // Evolution strategy with mirrored (antithetic) samples
+  kAntitheticEs
+};
+
+// Searches for genomes that maximize fitness. Each generation the
+// LearningModel asks for genomes, drives them, and tells the optimizer the
+// fitness they earned.
+class Optimizer {
+
+public:
+
+  virtual ~Optimizer() { }
+
+  // Forgets all search progress and prepares for genomes of genome_size
+  virtual void Reset(int genome_size) = 0;
+
+  // Fills population with population_size genomes to evaluate
+  virtual void Ask(int population_size, GenomePool* population) = 0;
+
+  // Reports fitness earned by each genome of a population
+  virtual void Tell(const GenomePool& population,
+    const vector<float>& fitness) = 0;
+
+  // Returns name of optimizer for display
+  virtual string GetName() const = 0;
+};
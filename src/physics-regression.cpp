@@ -0,0 +1,68 @@
+#include "physics-regression.h"
+#include <fstream>
+#include <iostream>
+
+namespace PhysicsRegression {
+
+  uint64_t RunScript(Track* track, int* crash_count) {
+    NeuralNetwork* no_network = nullptr;
+    Car car(track, 0, no_network);
+    car.SetDeterministic(true);
+
+    uint64_t hash = 14695981039346656037ULL;
+    uint32_t random_state = kScriptSeed;
+    CarInputs inputs;
+    *crash_count = 0;
+
+    for (int frame = 0; frame < kScriptFrames; frame++) {
+      if (frame % kScriptHoldFrames == 0) {
+        random_state = random_state * 1103515245 + 12345;
+        inputs.acceleration = (float)((random_state >> 16) % 5);
+        random_state = random_state * 1103515245 + 12345;
+        inputs.turning = (float)((int)((random_state >> 16) % 9) - 4);
+      }
+
+      car.FrameUpdate(inputs);
+      hash = car.HashPhysicsState(hash);
+      if (car.IsDisabled()) {
+        (*crash_count)++;
+        car.ResetPosition();
+      }
+    }
+    return hash;
+  }
+
+  bool VerifyTracks(vector<string> track_folders) {
+    bool all_match = true;
+    for (string folder : track_folders) {
+      Track track(folder);
+      int crash_count;
+      uint64_t hash = RunScript(&track, &crash_count);
+
+      uint64_t expected_hash = 0;
+      int expected_crash_count = -1;
+      std::ifstream golden(folder + "/" + kGoldenFileName);
+      golden >> expected_hash >> expected_crash_count;
+
+      bool match = golden && hash == expected_hash
+        && crash_count == expected_crash_count;
+      all_match = all_match && match;
+      std::cout << (match ? "PASS " : "FAIL ") << folder << ": hash " << hash
+        << " crashes " << crash_count << " (expected " << expected_hash
+        << " crashes " << expected_crash_count << ")" << std::endl;
+    }
+    return all_match;
+  }
+
+  void UpdateTracks(vector<string> track_folders) {
+    for (string folder : track_folders) {
+      Track track(folder);
+      int crash_count;
+      uint64_t hash = RunScript(&track, &crash_count);
+
+      std::ofstream golden(folder + "/" + kGoldenFileName);
+      golden << hash << " " << crash_count << std::endl;
+      std::cout << "Wrote " << folder << "/" << kGoldenFileName << std::endl;
+    }
+  }
+}
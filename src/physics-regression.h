@@ -0,0 +1,35 @@
+#pragma once
+
+#include "car.h"
+
+// Bit-exact regression check of deterministic physics. A Car is driven on
+// each track with a scripted input sequence, restarting whenever it crashes,
+// and a hash of its physics state after every frame is compared with the
+// golden value stored in the track folder.
+namespace PhysicsRegression {
+
+  // Number of frames the scripted Car is driven on each track
+  const int kScriptFrames = 3000;
+
+  // Number of frames each scripted input is held
+  const int kScriptHoldFrames = 20;
+
+  // Seed of the linear congruential generator choosing scripted inputs
+  const uint32_t kScriptSeed = 12345;
+
+  // Name of the golden file in each track folder
+  const string kGoldenFileName = "physics-golden.txt";
+
+  // Drives the input script on a track. Returns hash of the physics state
+  // after every frame and sets crash_count to the number of crashes.
+  uint64_t RunScript(Track* track, int* crash_count);
+
+  // Runs the script on each track folder and compares the result with the
+  // folder's golden file. Prints one line per track. Returns true if every
+  // track matches.
+  bool VerifyTracks(vector<string> track_folders);
+
+  // Runs the script on each track folder and overwrites its golden file.
+  // Only for intentional changes to deterministic physics.
+  void UpdateTracks(vector<string> track_folders);
+}
@@ -0,0 +1,190 @@
+#include "population-renderer.h"
+
+namespace {
+
+  // Rotates a unit quad corner by the instance's rotation and scales it to
+  // half_size. GLSL 1.20 runs on legacy and software (Mesa) contexts.
+  const string kLegacyVertexShader = R"(
+    #version 120
+    uniform vec2 half_size;
+    attribute vec3 instance;
+    varying vec2 tex_coord;
+
+    void main() {
+      vec2 corner = gl_Vertex.xy * half_size;
+      float c = cos(instance.z);
+      float s = sin(instance.z);
+      vec2 world = instance.xy
+        + vec2(c * corner.x - s * corner.y, s * corner.x + c * corner.y);
+      tex_coord = gl_MultiTexCoord0.xy;
+      gl_FrontColor = gl_Color;
+      gl_Position = gl_ModelViewProjectionMatrix * vec4(world, 0.0, 1.0);
+    }
+  )";
+
+  const string kLegacyFragmentShader = R"(
+    #version 120
+    uniform sampler2D car_texture;
+    varying vec2 tex_coord;
+
+    void main() {
+      gl_FragColor = texture2D(car_texture, tex_coord) * gl_Color;
+    }
+  )";
+
+  const string kProgrammableVertexShader = R"(
+    #version 330
+    uniform mat4 modelViewProjectionMatrix;
+    uniform vec2 half_size;
+    in vec4 position;
+    in vec2 texcoord;
+    in vec3 instance;
+    out vec2 tex_coord;
+
+    void main() {
+      vec2 corner = position.xy * half_size;
+      float c = cos(instance.z);
+      float s = sin(instance.z);
+      vec2 world = instance.xy
+        + vec2(c * corner.x - s * corner.y, s * corner.x + c * corner.y);
+      tex_coord = texcoord;
+      gl_Position = modelViewProjectionMatrix * vec4(world, 0.0, 1.0);
+    }
+  )";
+
+  const string kProgrammableFragmentShader = R"(
+    #version 330
+    uniform sampler2D car_texture;
+    uniform vec4 globalColor;
+    in vec2 tex_coord;
+    out vec4 fragment_color;
+
+    void main() {
+      fragment_color = texture(car_texture, tex_coord) * globalColor;
+    }
+  )";
+
+  // Corners of the unit quad in triangle strip order, top-left first
+  const vector<ofVec3f> kQuadCorners = {
+    ofVec3f(-1, -1), ofVec3f(1, -1), ofVec3f(-1, 1), ofVec3f(1, 1)
+  };
+  const vector<ofVec2f> kQuadTexCoords = {
+    ofVec2f(0, 0), ofVec2f(1, 0), ofVec2f(0, 1), ofVec2f(1, 1)
+  };
+}
+
+void PopulationRenderer::Setup(string image_path) {
+  // Normalized texture coordinates let one shader serve every renderer
+  bool using_arb_tex = ofGetUsingArbTex();
+  ofDisableArbTex();
+  image_.load(image_path);
+  if (using_arb_tex) {
+    ofEnableArbTex();
+  }
+
+  quad_.setVertexData(&kQuadCorners[0], kQuadCorners.size(), GL_STATIC_DRAW);
+  quad_.setTexCoordData(&kQuadTexCoords[0], kQuadTexCoords.size(),
+    GL_STATIC_DRAW);
+
+  batch_.setMode(OF_PRIMITIVE_TRIANGLES);
+  instanced_ = SetupShader();
+}
+
+bool PopulationRenderer::SetupShader() {
+#ifdef TARGET_OPENGLES
+  return false;
+#else
+  bool programmable = ofIsGLProgrammableRenderer();
+  // Attribute divisors are core from GL 3.3
+  if (!programmable && !GLEW_VERSION_3_3) {
+    return false;
+  }
+
+  if (!shader_.setupShaderFromSource(GL_VERTEX_SHADER, programmable
+    ? kProgrammableVertexShader : kLegacyVertexShader)
+    || !shader_.setupShaderFromSource(GL_FRAGMENT_SHADER, programmable
+      ? kProgrammableFragmentShader : kLegacyFragmentShader)) {
+    return false;
+  }
+  if (programmable) {
+    shader_.bindDefaults();
+  }
+  if (!shader_.linkProgram()) {
+    return false;
+  }
+
+  instance_location_ = shader_.getAttributeLocation("instance");
+  return instance_location_ >= 0;
+#endif
+}
+
+void PopulationRenderer::Draw(const vector<Car>& cars, float track_scale) {
+  if (cars.empty()) {
+    return;
+  }
+
+  // Every Car in a population shares one scale
+  float car_scale = cars[0].GetScale();
+  float half_width = image_.getWidth() * car_scale / 2;
+  float half_height = image_.getHeight() * car_scale / 2;
+
+  if (!instanced_) {
+    DrawBatched(cars, track_scale, half_width, half_height);
+    return;
+  }
+
+  instances_.resize(cars.size() * kInstanceSize);
+  for (unsigned i = 0; i < cars.size(); i++) {
+    instances_[i * kInstanceSize] = cars[i].GetX() * track_scale;
+    instances_[i * kInstanceSize + 1] = cars[i].GetY() * track_scale;
+    instances_[i * kInstanceSize + 2] = cars[i].GetRotation();
+  }
+
+  if ((int)cars.size() > instance_capacity_) {
+    instance_capacity_ = cars.size();
+    // ofVbo counts instances, each one stride of kInstanceSize floats
+    quad_.setAttributeData(instance_location_, &instances_[0], kInstanceSize,
+      cars.size(), GL_STREAM_DRAW, sizeof(float) * kInstanceSize);
+    quad_.setAttributeDivisor(instance_location_, 1);
+  } else {
+    quad_.updateAttributeData(instance_location_, &instances_[0],
+      cars.size());
+  }
+
+  shader_.begin();
+  shader_.setUniform2f("half_size", half_width, half_height);
+  shader_.setUniformTexture("car_texture", image_.getTexture(), 0);
+  quad_.drawInstanced(GL_TRIANGLE_STRIP, 0, kQuadCorners.size(), cars.size());
+  shader_.end();
+}
+
+bool PopulationRenderer::IsInstanced() const {
+  return instanced_;
+}
+
+void PopulationRenderer::DrawBatched(const vector<Car>& cars,
+  float track_scale, float half_width, float half_height) {
+  batch_.clear();
+
+  // Two triangles per Car, sharing the strip's middle corners
+  const int kTriangleCorners[] = { 0, 1, 2, 2, 1, 3 };
+  for (const Car& car : cars) {
+    float x = car.GetX() * track_scale;
+    float y = car.GetY() * track_scale;
+    float c = cos(car.GetRotation());
+    float s = sin(car.GetRotation());
+
+    for (int corner : kTriangleCorners) {
+      float corner_x = kQuadCorners[corner].x * half_width;
+      float corner_y = kQuadCorners[corner].y * half_height;
+      batch_.addVertex(ofVec3f(x + c * corner_x - s * corner_y,
+        y + s * corner_x + c * corner_y));
+      batch_.addTexCoord(image_.getTexture().getCoordFromPercent(
+        kQuadTexCoords[corner].x, kQuadTexCoords[corner].y));
+    }
+  }
+
+  image_.getTexture().bind();
+  batch_.draw();
+  image_.getTexture().unbind();
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ofMain.h"
+#include "car.h"
+
+// Draws every Car in a population with a single draw call. Where the GL
+// context supports instancing, one textured quad is drawn once per Car with
+// each Car's position and rotation read from a per-instance buffer.
+// Otherwise every Car's quad is transformed on the CPU into one batched mesh.
+class PopulationRenderer {
+
+public:
+
+  // Loads the car texture and shaders. Must be called on the GL thread.
+  void Setup(string image_path);
+
+  // Draws cars at their positions scaled by track_scale
+  void Draw(const vector<Car>& cars, float track_scale);
+
+  // Returns true if Cars are drawn with instancing
+  bool IsInstanced() const;
+
+private:
+
+  // Number of floats per Car in the instance buffer: x, y, rotation
+  int kInstanceSize = 3;
+
+  // Car texture shared by every Car in the population
+  ofImage image_;
+
+  // Positions the quad at each instance and samples image_
+  ofShader shader_;
+
+  // Unit quad corners and texture coordinates plus the instance buffer
+  ofVbo quad_;
+
+  // Location of the per-instance attribute in shader_
+  int instance_location_ = -1;
+
+  // Number of instances the instance buffer was allocated for
+  int instance_capacity_ = 0;
+
+  // Per-Car data uploaded each frame
+  vector<float> instances_;
+
+  // Mesh of every Car's quad, used when instancing is unavailable
+  ofMesh batch_;
+
+  // True if shader_ linked and the context supports attribute divisors
+  bool instanced_ = false;
+
+  // Compiles shader_ for the current renderer. Returns false on failure.
+  bool SetupShader();
+
+  // Draws by transforming each Car's quad into batch_
+  void DrawBatched(const vector<Car>& cars, float track_scale,
+    float half_width, float half_height);
+};
\ No newline at end of file
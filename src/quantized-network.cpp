@@ -0,0 +1,228 @@
+#include "quantized-network.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "car.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QUANTIZED_NETWORK_SSE2
+#endif
+
+namespace {
+
+  // Largest magnitude of a quantized weight and of a quantized input
+  const int kWeightLimit = 127;
+  const int kInputLimit = 32767;
+
+  // SIMD lanes per step of DotProduct
+  const int kLanes = 8;
+
+  // Returns dot product of count int16 inputs and int8 weights. count must
+  // be a multiple of kLanes.
+  int32_t DotProduct(const int16_t* inputs, const int8_t* weights,
+    int count) {
+#ifdef QUANTIZED_NETWORK_SSE2
+    __m128i sums = _mm_setzero_si128();
+    for (int i = 0; i < count; i += kLanes) {
+      __m128i x = _mm_loadu_si128((const __m128i*)(inputs + i));
+      // Sign-extend eight int8 weights to int16 by placing them in the high
+      // byte of each lane and shifting back down
+      __m128i w = _mm_loadl_epi64((const __m128i*)(weights + i));
+      w = _mm_srai_epi16(_mm_unpacklo_epi8(_mm_setzero_si128(), w), 8);
+      sums = _mm_add_epi32(sums, _mm_madd_epi16(x, w));
+    }
+    sums = _mm_add_epi32(sums,
+      _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2)));
+    sums = _mm_add_epi32(sums,
+      _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sums);
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < count; i++) {
+      sum += (int32_t)inputs[i] * weights[i];
+    }
+    return sum;
+#endif
+  }
+}
+
+bool QuantizedNetwork::Quantize(const NeuralNetwork* network) {
+  layers_.clear();
+  const MultilayerPerceptron* perceptron =
+    network->get_multilayer_perceptron_pointer();
+
+  for (size_t l = 0; l < perceptron->get_layers_number(); l++) {
+    const PerceptronLayer& source = perceptron->get_layer(l);
+    Layer layer;
+    layer.input_count = source.get_inputs_number();
+    layer.output_count = source.get_perceptrons_number();
+    if (layer.input_count > kMaxLayerWidth
+      || layer.output_count > kMaxLayerWidth) {
+      layers_.clear();
+      return false;
+    }
+
+    switch (source.get_activation_function()) {
+    case PerceptronLayer::Linear:
+      layer.activation = Activation::kLinear;
+      break;
+    case PerceptronLayer::Logistic:
+      layer.activation = Activation::kLogistic;
+      break;
+    case PerceptronLayer::HyperbolicTangent:
+      layer.activation = Activation::kHyperbolicTangent;
+      break;
+    default:
+      layers_.clear();
+      return false;
+    }
+
+    layer.padded_input_count =
+      (layer.input_count + kLanes - 1) / kLanes * kLanes;
+    layer.weights.assign(layer.padded_input_count * layer.output_count, 0);
+    layer.weight_scales.resize(layer.output_count);
+    layer.biases.resize(layer.output_count);
+
+    Vector<double> biases = source.get_biases();
+    Matrix<double> weights = source.get_synaptic_weights();
+    for (int neuron = 0; neuron < layer.output_count; neuron++) {
+      double largest = 0;
+      for (int input = 0; input < layer.input_count; input++) {
+        largest = std::max(largest, fabs(weights(input, neuron)));
+      }
+      float scale = largest > 0 ? largest / kWeightLimit : 1;
+
+      int8_t* row = &layer.weights[neuron * layer.padded_input_count];
+      for (int input = 0; input < layer.input_count; input++) {
+        row[input] = (int8_t)lround(weights(input, neuron) / scale);
+      }
+      layer.weight_scales[neuron] = scale;
+      layer.biases[neuron] = biases[neuron];
+    }
+    layers_.push_back(layer);
+  }
+  return !layers_.empty();
+}
+
+bool QuantizedNetwork::IsQuantized() const {
+  return !layers_.empty();
+}
+
+int QuantizedNetwork::GetInputCount() const {
+  return layers_.empty() ? 0 : layers_.front().input_count;
+}
+
+int QuantizedNetwork::GetOutputCount() const {
+  return layers_.empty() ? 0 : layers_.back().output_count;
+}
+
+void QuantizedNetwork::CalculateOutputs(const double* inputs,
+  double* outputs) const {
+  float values[kMaxLayerWidth];
+  for (int i = 0; i < GetInputCount(); i++) {
+    values[i] = inputs[i];
+  }
+
+  for (const Layer& layer : layers_) {
+    // One scale for the whole input vector keeps the dot product integer
+    float largest = 0;
+    for (int i = 0; i < layer.input_count; i++) {
+      largest = std::max(largest, fabs(values[i]));
+    }
+    float input_scale = largest > 0 ? largest / kInputLimit : 1;
+
+    alignas(16) int16_t quantized_inputs[kMaxLayerWidth] = { 0 };
+    for (int i = 0; i < layer.input_count; i++) {
+      quantized_inputs[i] = (int16_t)lround(values[i] / input_scale);
+    }
+
+    for (int neuron = 0; neuron < layer.output_count; neuron++) {
+      int32_t sum = DotProduct(quantized_inputs,
+        &layer.weights[neuron * layer.padded_input_count],
+        layer.padded_input_count);
+      float combination = sum * input_scale * layer.weight_scales[neuron]
+        + layer.biases[neuron];
+
+      switch (layer.activation) {
+      case Activation::kLinear:
+        values[neuron] = combination;
+        break;
+      case Activation::kLogistic:
+        values[neuron] = 1 / (1 + exp(-combination));
+        break;
+      case Activation::kHyperbolicTangent:
+        values[neuron] = tanh(combination);
+        break;
+      }
+    }
+  }
+
+  for (int i = 0; i < GetOutputCount(); i++) {
+    outputs[i] = values[i];
+  }
+}
+
+int QuantizedNetwork::GetParameterBytes() const {
+  int bytes = 0;
+  for (const Layer& layer : layers_) {
+    bytes += layer.weights.size() * sizeof(int8_t)
+      + (layer.weight_scales.size() + layer.biases.size()) * sizeof(float);
+  }
+  return bytes;
+}
+
+namespace QuantizedValidation {
+
+  namespace {
+
+    // How a single drive ended
+    struct Outcome {
+      bool crashed;
+      int laps;
+    };
+
+    Outcome Drive(Track* track, NeuralNetwork* network,
+      const QuantizedNetwork* quantized_network) {
+      Car car(track, 0, network);
+      car.SetQuantizedNetwork(quantized_network);
+      for (int frame = 0; frame < kMaxFrames && !car.IsDisabled(); frame++) {
+        car.FrameUpdate(car.CalculateCarInputs());
+      }
+      return Outcome{ car.IsDisabled(), car.GetLaps() };
+    }
+  }
+
+  bool VerifyTracks(vector<string> track_folders,
+    const vector<NeuralNetwork*>& networks) {
+    vector<QuantizedNetwork> quantized_networks(networks.size());
+    for (unsigned i = 0; i < networks.size(); i++) {
+      if (!quantized_networks[i].Quantize(networks[i])) {
+        std::cout << "FAIL network " << i << " cannot be quantized"
+          << std::endl;
+        return false;
+      }
+    }
+
+    bool all_pass = true;
+    for (string folder : track_folders) {
+      Track track(folder);
+      int agreements = 0;
+      for (unsigned i = 0; i < networks.size(); i++) {
+        Outcome float_outcome = Drive(&track, networks[i], nullptr);
+        Outcome quantized_outcome = Drive(&track, networks[i],
+          &quantized_networks[i]);
+        if (float_outcome.crashed == quantized_outcome.crashed
+          && float_outcome.laps == quantized_outcome.laps) {
+          agreements++;
+        }
+      }
+
+      bool pass = agreements >= kRequiredAgreement * networks.size();
+      all_pass = all_pass && pass;
+      std::cout << (pass ? "PASS " : "FAIL ") << folder << ": " << agreements
+        << " of " << networks.size() << " runs agree" << std::endl;
+    }
+    return all_pass;
+  }
+}
\ No newline at end of file
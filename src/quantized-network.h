@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "opennn.h"
+
+using namespace OpenNN;
+using std::vector;
+
+// Integer copy of a NeuralNetwork's multilayer perceptron for fast
+// inference. Weights are stored as int8 with one scale per neuron, each
+// layer's inputs are quantized to int16 with one scale per layer, and dot
+// products accumulate in int32 (eight lanes at a time with SSE2 where
+// available). Biases and activation functions stay in float.
+class QuantizedNetwork {
+
+public:
+
+  // Widest layer that can be quantized
+  static const int kMaxLayerWidth = 64;
+
+  // Quantizes the perceptron of network. Returns false, leaving this network
+  // empty, if a layer is too wide or uses an unsupported activation
+  // function.
+  bool Quantize(const NeuralNetwork* network);
+
+  // Returns true if Quantize has succeeded
+  bool IsQuantized() const;
+
+  // Returns number of inputs read and outputs written by CalculateOutputs
+  int GetInputCount() const;
+  int GetOutputCount() const;
+
+  // Calculates outputs from the first GetInputCount() inputs
+  void CalculateOutputs(const double* inputs, double* outputs) const;
+
+  // Returns bytes of memory used by the quantized weights and biases
+  int GetParameterBytes() const;
+
+private:
+
+  // Activation functions that can be quantized
+  enum class Activation {
+    kLinear,
+    kLogistic,
+    kHyperbolicTangent
+  };
+
+  // One perceptron layer
+  struct Layer {
+    int input_count;
+    int output_count;
+
+    // Weights of each neuron in turn, each row padded with zeros to
+    // padded_input_count so SIMD loads never read past a row
+    int padded_input_count;
+    vector<int8_t> weights;
+
+    // Value of one weight step for each neuron
+    vector<float> weight_scales;
+
+    vector<float> biases;
+    Activation activation;
+  };
+
+  vector<Layer> layers_;
+};
+
+// Checks that quantized inference drives like floating-point inference. Each
+// network is driven on each track twice, once with each inference mode, and
+// the runs agree if both crash or both survive and they finish on the same
+// lap.
+namespace QuantizedValidation {
+
+  // Number of frames each Car is driven for
+  const int kMaxFrames = 3000;
+
+  // Number of generations trained before validating. Random networks crash
+  // within a few frames in either mode, so they would agree trivially.
+  const int kTrainingGenerations = 30;
+
+  // Fraction of runs that must agree for a track to pass. Quantization
+  // rounding can tip a Car that barely clears a wall.
+  const float kRequiredAgreement = 0.95f;
+
+  // Drives networks on each track folder in both modes and prints one line
+  // per track. Returns true if every track passes.
+  bool VerifyTracks(vector<string> track_folders,
+    const vector<NeuralNetwork*>& networks);
+}
\ No newline at end of file
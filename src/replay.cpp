@@ -0,0 +1,255 @@
+#include "replay.h"
+#include <cstring>
+#include <fstream>
+#include "fitness-cache.h"
+#include "fixed-point.h"
+
+namespace {
+
+  // Identifies replay files and their format version
+  const uint32_t kReplayMagic = 0x50524447; // "GDRP"
+  const uint32_t kReplayVersion = 1;
+
+  // FNV-1a offset basis used to start physics state hashes
+  const uint64_t kHashBasis = 14695981039346656037ULL;
+
+  void WriteUint32(std::ostream& out, uint32_t value) {
+    for (int byte = 0; byte < 4; byte++) {
+      out.put((char)((value >> (8 * byte)) & 0xFF));
+    }
+  }
+
+  void WriteUint64(std::ostream& out, uint64_t value) {
+    WriteUint32(out, (uint32_t)value);
+    WriteUint32(out, (uint32_t)(value >> 32));
+  }
+
+  // Zigzag maps small negative and positive deltas to small unsigned values,
+  // which varints then store in few bytes
+  void WriteVarint(std::ostream& out, int32_t value) {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    while (zigzag >= 0x80) {
+      out.put((char)((zigzag & 0x7F) | 0x80));
+      zigzag >>= 7;
+    }
+    out.put((char)zigzag);
+  }
+
+  bool ReadUint32(std::istream& in, uint32_t* value) {
+    *value = 0;
+    for (int byte = 0; byte < 4; byte++) {
+      int next = in.get();
+      if (next == EOF) {
+        return false;
+      }
+      *value |= (uint32_t)next << (8 * byte);
+    }
+    return true;
+  }
+
+  bool ReadUint64(std::istream& in, uint64_t* value) {
+    uint32_t low;
+    uint32_t high;
+    if (!ReadUint32(in, &low) || !ReadUint32(in, &high)) {
+      return false;
+    }
+    *value = ((uint64_t)high << 32) | low;
+    return true;
+  }
+
+  bool ReadVarint(std::istream& in, int32_t* value) {
+    uint32_t zigzag = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      int next = in.get();
+      if (next == EOF) {
+        return false;
+      }
+      zigzag |= (uint32_t)(next & 0x7F) << shift;
+      if ((next & 0x80) == 0) {
+        *value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+        return true;
+      }
+    }
+    return false;
+  }
+}
+
+namespace ReplayFile {
+
+  Replay Record(Track* track, string track_folder, NeuralNetwork* network,
+    int max_frames, int decision_interval, bool quantized) {
+
+    Replay replay;
+    replay.track_folder = track_folder;
+    replay.genome_hash = FitnessCache::HashGenome(network);
+
+    Car car(track, 0, network);
+    car.SetDeterministic(true);
+    car.SetDecisionInterval(decision_interval);
+    QuantizedNetwork quantized_network;
+    if (quantized && quantized_network.Quantize(network)) {
+      car.SetQuantizedNetwork(&quantized_network);
+    }
+    for (int frame = 0; frame < max_frames && !car.IsDisabled(); frame++) {
+      CarInputs inputs = car.ClampInputs(car.NextInputs());
+      int32_t acceleration = FixedPoint::FromFloat(inputs.acceleration);
+      int32_t turning = FixedPoint::FromFloat(inputs.turning);
+      replay.accelerations.push_back(acceleration);
+      replay.turnings.push_back(turning);
+
+      // Drive with the recorded values so playback sees identical inputs
+      car.FrameUpdate(CarInputs(FixedPoint::ToFloat(acceleration),
+        FixedPoint::ToFloat(turning)));
+    }
+
+    replay.fitness = car.GetFitness();
+    replay.final_state_hash = car.HashPhysicsState(kHashBasis);
+    return replay;
+  }
+
+  bool Write(const Replay& replay, string path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+      return false;
+    }
+
+    uint32_t fitness_bits;
+    std::memcpy(&fitness_bits, &replay.fitness, sizeof(fitness_bits));
+
+    WriteUint32(out, kReplayMagic);
+    WriteUint32(out, kReplayVersion);
+    WriteUint32(out, replay.track_folder.size());
+    out.write(replay.track_folder.data(), replay.track_folder.size());
+    WriteUint32(out, replay.generation);
+    WriteUint32(out, fitness_bits);
+    WriteUint64(out, replay.genome_hash);
+    WriteUint64(out, replay.final_state_hash);
+    WriteUint32(out, replay.accelerations.size());
+
+    int32_t previous_acceleration = 0;
+    int32_t previous_turning = 0;
+    for (unsigned i = 0; i < replay.accelerations.size(); i++) {
+      WriteVarint(out, replay.accelerations[i] - previous_acceleration);
+      WriteVarint(out, replay.turnings[i] - previous_turning);
+      previous_acceleration = replay.accelerations[i];
+      previous_turning = replay.turnings[i];
+    }
+    return (bool)out;
+  }
+
+  bool Read(string path, Replay* replay) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+      return false;
+    }
+    uint64_t file_size = in.tellg();
+    in.seekg(0);
+
+    uint32_t magic;
+    uint32_t version;
+    if (!ReadUint32(in, &magic) || magic != kReplayMagic
+      || !ReadUint32(in, &version) || version != kReplayVersion) {
+      return false;
+    }
+
+    // Lengths are checked against the bytes left so a corrupt header
+    // cannot request a huge allocation
+    uint32_t folder_length;
+    if (!ReadUint32(in, &folder_length)
+      || folder_length > file_size - (uint64_t)in.tellg()) {
+      return false;
+    }
+    replay->track_folder.resize(folder_length);
+    if (folder_length > 0
+      && !in.read(&replay->track_folder[0], folder_length)) {
+      return false;
+    }
+
+    uint32_t generation;
+    uint32_t fitness_bits;
+    uint32_t frame_count;
+    if (!ReadUint32(in, &generation) || !ReadUint32(in, &fitness_bits)
+      || !ReadUint64(in, &replay->genome_hash)
+      || !ReadUint64(in, &replay->final_state_hash)
+      || !ReadUint32(in, &frame_count)) {
+      return false;
+    }
+
+    // Each frame stores two varints of at least one byte
+    if ((uint64_t)frame_count * 2 > file_size - (uint64_t)in.tellg()) {
+      return false;
+    }
+    replay->generation = generation;
+    std::memcpy(&replay->fitness, &fitness_bits, sizeof(fitness_bits));
+
+    replay->accelerations.resize(frame_count);
+    replay->turnings.resize(frame_count);
+    int32_t acceleration = 0;
+    int32_t turning = 0;
+    for (uint32_t i = 0; i < frame_count; i++) {
+      int32_t acceleration_delta;
+      int32_t turning_delta;
+      if (!ReadVarint(in, &acceleration_delta)
+        || !ReadVarint(in, &turning_delta)) {
+        return false;
+      }
+      acceleration += acceleration_delta;
+      turning += turning_delta;
+      replay->accelerations[i] = acceleration;
+      replay->turnings[i] = turning;
+    }
+    return true;
+  }
+}
+
+void ReplayPlayer::Start(const Replay& replay, Car car) {
+  replay_ = replay;
+  car.SetDeterministic(true);
+  initial_car_ = car;
+  car_ = car;
+  frame_ = 0;
+  active_ = true;
+}
+
+void ReplayPlayer::Advance(int frame_count) {
+  for (int i = 0; i < frame_count && !IsFinished(); i++) {
+    car_.FrameUpdate(CarInputs(
+      FixedPoint::ToFloat(replay_.accelerations[frame_]),
+      FixedPoint::ToFloat(replay_.turnings[frame_])));
+    frame_++;
+  }
+  if (IsFinished()) {
+    active_ = false;
+  }
+}
+
+void ReplayPlayer::Seek(int frame) {
+  car_ = initial_car_;
+  frame_ = 0;
+  Advance(frame);
+}
+
+Car* ReplayPlayer::GetCar() {
+  return &car_;
+}
+
+int ReplayPlayer::GetFrame() const {
+  return frame_;
+}
+
+bool ReplayPlayer::IsFinished() const {
+  return frame_ >= (int)replay_.accelerations.size();
+}
+
+bool ReplayPlayer::MatchesRecording() const {
+  return IsFinished()
+    && car_.HashPhysicsState(kHashBasis) == replay_.final_state_hash;
+}
+
+bool ReplayPlayer::IsActive() const {
+  return active_;
+}
+
+void ReplayPlayer::Stop() {
+  active_ = false;
+}
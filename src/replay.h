@@ -0,0 +1,94 @@
+#pragma once
+
+#include "car.h"
+
+// Inputs that drove one Car through a run in deterministic physics. Since
+// deterministic physics is bit-exact, the inputs alone reconstruct the
+// trajectory on the same track.
+struct Replay {
+  // Folder of the track the run was recorded on
+  string track_folder;
+
+  // Generation the Car belonged to
+  int generation = 0;
+
+  // Fitness the Car earned on the track
+  float fitness = 0;
+
+  // Hash of the network parameters that produced the inputs
+  uint64_t genome_hash = 0;
+
+  // Car::HashPhysicsState after the last frame. Used to verify playback.
+  uint64_t final_state_hash = 0;
+
+  // Fixed-point acceleration and turning inputs for each frame
+  vector<int32_t> accelerations;
+  vector<int32_t> turnings;
+};
+
+namespace ReplayFile {
+
+  // Drives a network on a track in deterministic physics until it crashes
+  // or max_frames pass, recording its inputs. Inputs are recalculated every
+  // decision_interval frames as in training, with a quantized copy of the
+  // network if quantized is true.
+  Replay Record(Track* track, string track_folder, NeuralNetwork* network,
+    int max_frames, int decision_interval, bool quantized);
+
+  // Writes replay to a file. Inputs are stored as zigzag varint deltas from
+  // the previous frame, so held or slowly changing inputs take one byte.
+  // Returns false if the file could not be written.
+  bool Write(const Replay& replay, string path);
+
+  // Reads replay written by Write. Returns false if the file is missing or
+  // malformed.
+  bool Read(string path, Replay* replay);
+}
+
+// Plays a Replay back by feeding its inputs to a Car in deterministic
+// physics. Playback can run at any speed and seek to any frame.
+class ReplayPlayer {
+
+public:
+
+  // Starts playing replay with a Car at its track's start position
+  void Start(const Replay& replay, Car car);
+
+  // Advances playback by up to frame_count frames
+  void Advance(int frame_count);
+
+  // Restarts playback and advances to a frame
+  void Seek(int frame);
+
+  // Returns Car being replayed
+  Car* GetCar();
+
+  // Returns number of frames played
+  int GetFrame() const;
+
+  // Returns true if every recorded frame has been played
+  bool IsFinished() const;
+
+  // Returns true if playback has finished in the recorded final state
+  bool MatchesRecording() const;
+
+  // Returns true if Start has been called since the last Stop and playback
+  // has not finished
+  bool IsActive() const;
+
+  // Ends playback. Needed before the replayed Car's Track is deleted.
+  void Stop();
+
+private:
+
+  Replay replay_;
+
+  // Car at the start of playback, kept for seeking backward
+  Car initial_car_;
+
+  // Car at the current frame of playback
+  Car car_;
+
+  int frame_ = 0;
+  bool active_ = false;
+};
@@ -0,0 +1,173 @@
+#include "selection-engine.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+SelectionEngine::SelectionEngine() {
+  random_engine_.Seed(std::random_device()());
+}
+
+void SelectionEngine::SetSeed(unsigned seed) {
+  random_engine_.Seed(seed);
+}
+
+void SelectionEngine::SetSelectionMethod(SelectionMethod selection_method) {
+  this->selection_method_ = selection_method;
+}
+
+void SelectionEngine::SetCrossoverMethod(CrossoverMethod crossover_method) {
+  this->crossover_method_ = crossover_method;
+}
+
+void SelectionEngine::SetRankStandardDeviation(
+  float rank_standard_deviation) {
+  this->rank_standard_deviation_ = rank_standard_deviation;
+}
+
+void SelectionEngine::SetTournamentSize(int tournament_size) {
+  this->tournament_size_ = std::max(1, tournament_size);
+}
+
+void SelectionEngine::SetTruncationFraction(float truncation_fraction) {
+  this->truncation_fraction_ =
+    std::min(std::max(truncation_fraction, 0.0f), 1.0f);
+}
+
+void SelectionEngine::SetMutationRate(float mutation_rate) {
+  this->mutation_rate_ = mutation_rate;
+}
+
+void SelectionEngine::Randomize(GenomePool* pool) {
+  // Genomes are contiguous, so the whole pool is filled in one batch
+  if (pool->GetGenomeCount() > 0) {
+    random_engine_.FillUniform(pool->GetGenome(0),
+      pool->GetGenomeCount() * pool->GetGenomeSize(), -1, 1);
+  }
+}
+
+vector<int> SelectionEngine::SelectElites(const vector<float>& fitness,
+  int count) const {
+
+  vector<int> indices(fitness.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  count = std::min(std::max(count, 0), (int)indices.size());
+
+  std::partial_sort(indices.begin(), indices.begin() + count, indices.end(),
+    [&fitness](int first, int second) {
+      return fitness[first] > fitness[second];
+    });
+  indices.resize(count);
+  return indices;
+}
+
+void SelectionEngine::Reproduce(const GenomePool& parents,
+  const vector<float>& fitness, int elite_count, int offspring_count,
+  GenomePool* offspring) {
+
+  int genome_size = parents.GetGenomeSize();
+  offspring->Resize(offspring_count, genome_size);
+  if (parents.GetGenomeCount() == 0) {
+    Randomize(offspring);
+    return;
+  }
+
+  // Elites are copied in order, repeating if there are fewer parents than
+  // elite slots
+  vector<int> elites = SelectElites(fitness,
+    std::min(elite_count, offspring_count));
+  int copied = std::min(elite_count, offspring_count);
+  for (int i = 0; i < copied; i++) {
+    const double* elite = parents.GetGenome(elites[i % elites.size()]);
+    std::copy(elite, elite + genome_size, offspring->GetGenome(i));
+  }
+
+  PrepareSelection(fitness);
+  for (int i = copied; i < offspring_count; i++) {
+    const double* first = parents.GetGenome(SelectParent(fitness));
+    const double* second = parents.GetGenome(SelectParent(fitness));
+    Recombine(first, second, offspring->GetGenome(i), genome_size);
+  }
+}
+
+void SelectionEngine::Recombine(const double* first, const double* second,
+  double* child, int size) {
+
+  mutation_draws_.resize(size);
+  random_engine_.FillUniform(mutation_draws_.data(), size, -mutation_rate_,
+    mutation_rate_);
+  if (crossover_method_ != CrossoverMethod::kArithmetic) {
+    crossover_draws_.resize(size);
+    random_engine_.FillUniform(crossover_draws_.data(), size, 0, 1);
+  }
+
+  const double* mutation = mutation_draws_.data();
+  const double* unit = crossover_draws_.data();
+  switch (crossover_method_) {
+  case CrossoverMethod::kArithmetic:
+    for (int i = 0; i < size; i++) {
+      child[i] = (first[i] + second[i]) / 2 + mutation[i];
+    }
+    break;
+  case CrossoverMethod::kUniform:
+    for (int i = 0; i < size; i++) {
+      child[i] = (unit[i] < 0.5 ? first[i] : second[i]) + mutation[i];
+    }
+    break;
+  case CrossoverMethod::kSimulatedBinary:
+    for (int i = 0; i < size; i++) {
+      double u = unit[i];
+      double beta = u <= 0.5
+        ? pow(2 * u, 1 / (kSbxDistributionIndex + 1))
+        : pow(1 / (2 * (1 - u)), 1 / (kSbxDistributionIndex + 1));
+      child[i] = ((1 + beta) * first[i] + (1 - beta) * second[i]) / 2
+        + mutation[i];
+    }
+    break;
+  }
+}
+
+FastRandom& SelectionEngine::GetRandomEngine() {
+  return random_engine_;
+}
+
+void SelectionEngine::PrepareSelection(const vector<float>& fitness) {
+  int ranked_count = 0;
+  switch (selection_method_) {
+  case SelectionMethod::kRank:
+    ranked_count = (int)ceil(rank_standard_deviation_ * kRankedDeviations) + 1;
+    break;
+  case SelectionMethod::kTruncation:
+    ranked_count = (int)ceil(truncation_fraction_ * fitness.size());
+    break;
+  case SelectionMethod::kTournament:
+    // Tournaments compare fitness directly and need no ranking
+    ranked_indices_.clear();
+    return;
+  }
+
+  ranked_indices_ = SelectElites(fitness, std::max(1, ranked_count));
+}
+
+int SelectionEngine::SelectParent(const vector<float>& fitness) {
+  if (selection_method_ == SelectionMethod::kTournament) {
+    std::uniform_int_distribution<int> contender(0, fitness.size() - 1);
+    int winner = contender(random_engine_);
+    for (int i = 1; i < tournament_size_; i++) {
+      int challenger = contender(random_engine_);
+      if (fitness[challenger] > fitness[winner]) {
+        winner = challenger;
+      }
+    }
+    return winner;
+  }
+
+  if (selection_method_ == SelectionMethod::kTruncation) {
+    std::uniform_int_distribution<int> rank(0, ranked_indices_.size() - 1);
+    return ranked_indices_[rank(random_engine_)];
+  }
+
+  std::normal_distribution<float> rank(0, rank_standard_deviation_);
+  int drawn_rank = (int)fabs(rank(random_engine_));
+  return ranked_indices_[std::min(drawn_rank,
+    (int)ranked_indices_.size() - 1)];
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <random>
+#include "fast-random.h"
+#include "genome-pool.h"
+
+// How parents are chosen from a ranked population
+enum class SelectionMethod {
+  // Rank drawn from a half-normal distribution centered on the best genome
+  kRank,
+  // Best of a few genomes chosen uniformly at random
+  kTournament,
+  // Uniformly random genome from the most fit fraction of the population
+  kTruncation
+};
+
+// How two parent genomes are combined into one offspring
+enum class CrossoverMethod {
+  // Average of the two parents
+  kArithmetic,
+  // Each parameter copied from a randomly chosen parent
+  kUniform,
+  // Simulated binary crossover (SBX)
+  kSimulatedBinary
+};
+
+// Produces the next generation's genomes from the current generation's
+// genomes and fitnesses. Only the genomes that selection can reach are
+// ranked, so producing a generation stays close to linear in population size.
+class SelectionEngine {
+
+public:
+
+  // Constructs engine seeded from std::random_device
+  SelectionEngine();
+
+  // Reseeds random number generator so generations can be reproduced
+  void SetSeed(unsigned seed);
+
+  void SetSelectionMethod(SelectionMethod selection_method);
+  void SetCrossoverMethod(CrossoverMethod crossover_method);
+
+  // Standard deviation of ranks chosen by SelectionMethod::kRank
+  void SetRankStandardDeviation(float rank_standard_deviation);
+
+  // Number of genomes competing in each SelectionMethod::kTournament draw
+  void SetTournamentSize(int tournament_size);
+
+  // Fraction of population eligible under SelectionMethod::kTruncation
+  void SetTruncationFraction(float truncation_fraction);
+
+  // Largest amount added to or subtracted from each offspring parameter
+  void SetMutationRate(float mutation_rate);
+
+  // Fills every genome with uniformly random parameters in [-1, 1]
+  void Randomize(GenomePool* pool);
+
+  // Returns indices of the count most fit genomes from most to least fit.
+  // The rest of the population is not sorted.
+  vector<int> SelectElites(const vector<float>& fitness, int count) const;
+
+  // Fills offspring with offspring_count genomes. The elite_count most fit
+  // parents are copied unchanged to the front, the rest are mutated
+  // crossovers of selected parents.
+  void Reproduce(const GenomePool& parents, const vector<float>& fitness,
+    int elite_count, int offspring_count, GenomePool* offspring);
+
+  // Writes a mutated crossover of two genomes of length size into child.
+  // Random draws are made in batches first, so crossover and mutation are a
+  // single pass over the genomes.
+  void Recombine(const double* first, const double* second, double* child,
+    int size);
+
+  // Returns random number generator shared by the engine's operators
+  FastRandom& GetRandomEngine();
+
+private:
+
+  // Distribution index of simulated binary crossover. Higher keeps offspring
+  // closer to their parents.
+  float kSbxDistributionIndex = 15;
+
+  // Number of standard deviations of rank selection to rank ahead of time.
+  // Ranks drawn beyond this are clamped to the last ranked genome.
+  float kRankedDeviations = 4;
+
+  SelectionMethod selection_method_ = SelectionMethod::kRank;
+  CrossoverMethod crossover_method_ = CrossoverMethod::kArithmetic;
+  float rank_standard_deviation_ = 6;
+  int tournament_size_ = 3;
+  float truncation_fraction_ = 0.2f;
+  float mutation_rate_ = 1.0;
+
+  FastRandom random_engine_;
+
+  // Per-parameter crossover and mutation draws for the child being
+  // recombined. Kept between calls to avoid reallocating.
+  vector<double> crossover_draws_;
+  vector<double> mutation_draws_;
+
+  // Indices of the most fit genomes in descending order of fitness. Only as
+  // many genomes as the selection method can choose are ranked.
+  vector<int> ranked_indices_;
+
+  // Ranks the genomes reachable by the selection method
+  void PrepareSelection(const vector<float>& fitness);
+
+  // Returns index of one parent chosen by the selection method
+  int SelectParent(const vector<float>& fitness);
+};
@@ -0,0 +1,62 @@
+#include "spatial-hash.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialHash::SpatialHash(float cell_size) {
+  cell_size_ = cell_size;
+}
+
+void SpatialHash::Build(const vector<HashedPoint>& points, int width,
+  int height) {
+  columns_ = std::max(1, (int)std::ceil(width / cell_size_));
+  rows_ = std::max(1, (int)std::ceil(height / cell_size_));
+  cell_starts_.assign(columns_ * rows_ + 1, 0);
+
+  for (const HashedPoint& point : points) {
+    cell_starts_[GetRow(point.y) * columns_ + GetColumn(point.x) + 1]++;
+  }
+  for (unsigned cell = 1; cell < cell_starts_.size(); cell++) {
+    cell_starts_[cell] += cell_starts_[cell - 1];
+  }
+
+  sorted_points_.resize(points.size());
+  cell_cursors_.assign(cell_starts_.begin(), cell_starts_.end() - 1);
+  for (const HashedPoint& point : points) {
+    int cell = GetRow(point.y) * columns_ + GetColumn(point.x);
+    sorted_points_[cell_cursors_[cell]++] = point;
+  }
+}
+
+void SpatialHash::FindNear(float x, float y, float radius,
+  vector<int>* ids) const {
+  if (sorted_points_.empty()) {
+    return;
+  }
+
+  float square_radius = radius * radius;
+  for (int row = GetRow(y - radius); row <= GetRow(y + radius); row++) {
+    for (int column = GetColumn(x - radius); column <= GetColumn(x + radius);
+      column++) {
+      int cell = row * columns_ + column;
+      for (int i = cell_starts_[cell]; i < cell_starts_[cell + 1]; i++) {
+        float dx = sorted_points_[i].x - x;
+        float dy = sorted_points_[i].y - y;
+        if (dx * dx + dy * dy <= square_radius) {
+          ids->push_back(sorted_points_[i].id);
+        }
+      }
+    }
+  }
+}
+
+int SpatialHash::GetSize() const {
+  return sorted_points_.size();
+}
+
+int SpatialHash::GetColumn(float x) const {
+  return std::min(columns_ - 1, std::max(0, (int)std::floor(x / cell_size_)));
+}
+
+int SpatialHash::GetRow(float y) const {
+  return std::min(rows_ - 1, std::max(0, (int)std::floor(y / cell_size_)));
+}
\ No newline at end of file
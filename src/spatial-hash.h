@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+using std::vector;
+
+// Point stored in a SpatialHash
+struct HashedPoint {
+  HashedPoint() {
+    this->id = -1;
+    this->x = 0;
+    this->y = 0;
+  }
+
+  HashedPoint(int id, float x, float y) {
+    this->id = id;
+    this->x = x;
+    this->y = y;
+  }
+
+  // Caller's identifier for the point, such as a Car's population index
+  int id;
+  float x;
+  float y;
+};
+
+// Uniform grid of points rebuilt every frame. Points are bucketed by cell
+// with a counting sort into one flat array, so building takes linear time
+// without allocating once warmed up, and a radius query only visits the
+// cells the radius overlaps.
+class SpatialHash {
+
+public:
+
+  // Constructs grid with square cells cell_size pixels wide
+  explicit SpatialHash(float cell_size);
+
+  // Replaces contents with points in a width by height area. Points outside
+  // it are placed in the nearest edge cell.
+  void Build(const vector<HashedPoint>& points, int width, int height);
+
+  // Appends ids of points within radius of (x, y) to ids
+  void FindNear(float x, float y, float radius, vector<int>* ids) const;
+
+  // Returns number of points in the grid
+  int GetSize() const;
+
+private:
+
+  float cell_size_;
+  int columns_ = 0;
+  int rows_ = 0;
+
+  // Points sorted by cell. Cell c holds points cell_starts_[c] up to
+  // cell_starts_[c + 1].
+  vector<HashedPoint> sorted_points_;
+  vector<int> cell_starts_;
+
+  // Next free slot of each cell while building
+  vector<int> cell_cursors_;
+
+  // Returns column or row of a coordinate, clamped to the grid
+  int GetColumn(float x) const;
+  int GetRow(float y) const;
+};
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "sweep-runner.h"
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+SweepRunner::SweepRunner(string track_folder, int thread_count) {
+  track_.reset(new Track(track_folder));
+  track_folder_ = track_folder;
+  thread_count_ = std::max(1, thread_count);
+}
+
+bool SweepRunner::AddGrid(const vector<SweepParameter>& parameters) {
+  // Counts through every combination like an odometer
+  vector<int> value_indices(parameters.size(), 0);
+  while (true) {
+    if (!AddConfig(parameters, value_indices)) {
+      return false;
+    }
+    unsigned digit = 0;
+    while (digit < parameters.size()
+      && ++value_indices[digit] == (int)parameters[digit].values.size()) {
+      value_indices[digit] = 0;
+      digit++;
+    }
+    if (digit == parameters.size()) {
+      return true;
+    }
+  }
+}
+
+bool SweepRunner::AddRandom(const vector<SweepParameter>& parameters,
+  int count, uint32_t seed) {
+  std::mt19937 random_engine(seed);
+  vector<int> value_indices(parameters.size());
+  for (int i = 0; i < count; i++) {
+    for (unsigned j = 0; j < parameters.size(); j++) {
+      std::uniform_int_distribution<int> value(0,
+        (int)parameters[j].values.size() - 1);
+      value_indices[j] = value(random_engine);
+    }
+    if (!AddConfig(parameters, value_indices)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int SweepRunner::GetConfigCount() const {
+  return configs_.size();
+}
+
+bool SweepRunner::AddConfig(const vector<SweepParameter>& parameters,
+  const vector<int>& value_indices) {
+  TrainingConfig config;
+  for (unsigned i = 0; i < parameters.size(); i++) {
+    if (parameters[i].values.empty()
+      || !config.Set(parameters[i].key,
+        parameters[i].values[value_indices[i]])) {
+      return false;
+    }
+  }
+  if (config.IsValid()) {
+    configs_.push_back(config);
+  }
+  return true;
+}
+
+void SweepRunner::Run(int max_generations) {
+  max_generations = std::max(1, max_generations);
+  results_.assign(configs_.size(), SweepResult());
+  vector<std::unique_ptr<LearningModel>> models(configs_.size());
+  vector<int> trials(configs_.size());
+  for (unsigned i = 0; i < configs_.size(); i++) {
+    results_[i].config = configs_[i];
+    trials[i] = i;
+  }
+
+  int rung_generations = std::min(kFirstRungGenerations, max_generations);
+  while (!trials.empty()) {
+    TrainTrials(trials, models, rung_generations);
+    for (int trial : trials) {
+      results_[trial].generations = rung_generations;
+    }
+    if (rung_generations == max_generations) {
+      break;
+    }
+
+    // The worse half of this rung is stopped
+    std::sort(trials.begin(), trials.end(), [this](int a, int b) {
+      return results_[a].best_fitness > results_[b].best_fitness;
+    });
+    int survivor_count = std::max(1, (int)trials.size() / 2);
+    for (unsigned i = survivor_count; i < trials.size(); i++) {
+      results_[trials[i]].stopped_early = true;
+      models[trials[i]].reset();
+    }
+    trials.resize(survivor_count);
+    rung_generations = std::min(rung_generations * 2, max_generations);
+  }
+
+  std::stable_sort(results_.begin(), results_.end(),
+    [](const SweepResult& a, const SweepResult& b) {
+      if (a.generations != b.generations) {
+        return a.generations > b.generations;
+      }
+      return a.best_fitness > b.best_fitness;
+    });
+}
+
+void SweepRunner::TrainTrials(const vector<int>& trials,
+  vector<std::unique_ptr<LearningModel>>& models, int generations) {
+  std::atomic<unsigned> next_trial(0);
+  auto train = [&]() {
+    for (unsigned i = next_trial++; i < trials.size(); i = next_trial++) {
+      int trial = trials[i];
+      if (!models[trial]) {
+        models[trial].reset(new LearningModel(track_.get(), track_folder_,
+          configs_[trial]));
+        models[trial]->GenerateRandom();
+      }
+
+      LearningModel& model = *models[trial];
+      SweepResult& result = results_[trial];
+      while (model.GetGenerationNumber() <= generations) {
+        int generation_number = model.GetGenerationNumber();
+        model.FrameUpdate();
+        if (model.GetGenerationNumber() != generation_number) {
+          result.best_fitness = std::max(result.best_fitness,
+            model.GetLastGenerationTopFitness());
+        }
+      }
+    }
+  };
+
+  vector<std::thread> workers;
+  int worker_count = std::min<int>(thread_count_, trials.size());
+  for (int i = 0; i < worker_count; i++) {
+    workers.emplace_back(train);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+const vector<SweepResult>& SweepRunner::GetResults() const {
+  return results_;
+}
+
+void SweepRunner::PrintResults() const {
+  std::cout << std::setw(6) << "rank" << std::setw(14) << "best fitness"
+    << std::setw(13) << "generations" << "  config" << std::endl;
+  for (unsigned i = 0; i < results_.size(); i++) {
+    const SweepResult& result = results_[i];
+    std::cout << std::setw(6) << i + 1 << std::setw(14) << std::fixed
+      << std::setprecision(1) << result.best_fitness << std::setw(13)
+      << (std::to_string(result.generations)
+        + (result.stopped_early ? "*" : ""))
+      << "  " << result.config.ToString() << std::endl;
+  }
+  std::cout << "* stopped early for falling behind" << std::endl;
+}
\ No newline at end of file
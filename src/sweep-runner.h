@@ -0,0 +1,91 @@
+#pragma once
+
+#include <memory>
+#include "learning-model.h"
+
+// A hyperparameter to sweep and the values to try, in TrainingConfig::Set
+// syntax
+struct SweepParameter {
+  string key;
+  vector<string> values;
+};
+
+// Outcome of training one swept TrainingConfig
+struct SweepResult {
+  TrainingConfig config;
+
+  // Number of generations trained before finishing or being stopped
+  int generations = 0;
+
+  // Highest fitness of any finished generation
+  float best_fitness = 0;
+
+  // True if the config was stopped for falling behind the others
+  bool stopped_early = false;
+};
+
+// Trains many TrainingConfigs on one Track in parallel and ranks them by the
+// best fitness they reach. Configs are trained with successive halving:
+// every config trains for a first rung of generations, the better half
+// continues for twice as many, and so on until max_generations, so clearly
+// losing configs stop early. The Track is loaded once and only read.
+class SweepRunner {
+
+public:
+
+  // Constructs runner training on the Track in track_folder with up to
+  // thread_count configs at a time
+  SweepRunner(string track_folder, int thread_count);
+
+  // Adds a config for every combination of parameter values. Returns false
+  // if a value is malformed.
+  bool AddGrid(const vector<SweepParameter>& parameters);
+
+  // Adds count configs, each taking a uniformly random value of every
+  // parameter. Returns false if a value is malformed.
+  bool AddRandom(const vector<SweepParameter>& parameters, int count,
+    uint32_t seed);
+
+  // Returns number of configs added
+  int GetConfigCount() const;
+
+  // Trains every added config for at most max_generations generations
+  void Run(int max_generations);
+
+  // Returns results of the last Run, best first
+  const vector<SweepResult>& GetResults() const;
+
+  // Prints a table of the last Run's results, best first
+  void PrintResults() const;
+
+private:
+
+  // Number of generations every config is trained for before the first
+  // halving
+  int kFirstRungGenerations = 5;
+
+  // Track shared by every LearningModel
+  std::unique_ptr<Track> track_;
+
+  // Folder track_ was loaded from
+  string track_folder_;
+
+  // Maximum number of configs trained at once
+  int thread_count_;
+
+  // Configs added to the sweep
+  vector<TrainingConfig> configs_;
+
+  // Results of the last Run, best first
+  vector<SweepResult> results_;
+
+  // Adds config built from the default by setting each key to its value.
+  // Returns false if a value is malformed. Invalid combinations are skipped.
+  bool AddConfig(const vector<SweepParameter>& parameters,
+    const vector<int>& value_indices);
+
+  // Trains each of the trials' models until it has finished generations
+  // generations, thread_count_ models at a time
+  void TrainTrials(const vector<int>& trials,
+    vector<std::unique_ptr<LearningModel>>& models, int generations);
+};
\ No newline at end of file
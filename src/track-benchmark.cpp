@@ -0,0 +1,126 @@
+#include "track-benchmark.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "learning-model.h"
+
+namespace TrackBenchmark {
+
+  // Returns seconds elapsed since start
+  double GetSecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  Result Measure(const TrackShape& shape, string folder) {
+    Result result;
+    result.shape = shape;
+    Track track(folder);
+    int segment_count = track.GetSegmentCount();
+
+    // Rays are cast from the start of every segment, facing along it, in
+    // a fan of bearings
+    const vector<float> bearings = { -1.5f, -1, -0.5f, 0, 0.5f, 1, 1.5f };
+    int bearing_count = bearings.size();
+
+    // Cars are placed before the clock starts so only ray casts are timed
+    NeuralNetwork* no_network = nullptr;
+    vector<Car> cars;
+    cars.reserve(segment_count);
+    for (int segment = 0; segment < segment_count; segment++) {
+      cars.push_back(Car(&track, segment, no_network));
+      cars.back().StartAtSegment(segment);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kQueryCount; i++) {
+      const Car& car = cars[i / bearing_count % segment_count];
+      result.checksum += car.CastRay(bearings[i % bearing_count]);
+    }
+    result.rays_per_second = kQueryCount / GetSecondsSince(start);
+
+    // Distance queries are spread between consecutive path points
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kQueryCount; i++) {
+      int segment = i % segment_count;
+      vector<float> first = track.GetSegmentStart(segment);
+      vector<float> second =
+        track.GetSegmentStart((segment + 1) % segment_count);
+      float weight = (i / segment_count % 8) / 8.0f;
+      result.checksum += track.FindDistAlongTrack({
+        first[0] + weight * (second[0] - first[0]),
+        first[1] + weight * (second[1] - first[1]) });
+    }
+    result.distance_queries_per_second = kQueryCount / GetSecondsSince(start);
+
+    LearningModel learning_model(&track, folder, TrainingConfig());
+    learning_model.GenerateRandom();
+    int frames = 0;
+    start = std::chrono::steady_clock::now();
+    while (learning_model.GetGenerationNumber() <= kGenerations) {
+      learning_model.FrameUpdate();
+      frames++;
+    }
+    double seconds = GetSecondsSince(start);
+    result.frames_per_second = frames / seconds;
+    result.generations_per_second = kGenerations / seconds;
+    return result;
+  }
+
+  bool Run(string folder) {
+    vector<TrackShape> shapes;
+    for (int size : kSizes) {
+      shapes.push_back(TrackShape());
+      shapes.back().size = size;
+    }
+    for (int road_width : kRoadWidths) {
+      shapes.push_back(TrackShape());
+      shapes.back().road_width = road_width;
+    }
+    for (float curvature : kCurvatures) {
+      shapes.push_back(TrackShape());
+      shapes.back().curvature = curvature;
+    }
+    for (int checkpoint_count : kCheckpointCounts) {
+      shapes.push_back(TrackShape());
+      shapes.back().checkpoint_count = checkpoint_count;
+    }
+
+    ofDirectory::createDirectory(folder, false, true);
+    std::ofstream csv(folder + "/benchmark.csv");
+    csv << "size,road_width,curvature,checkpoints,rays_per_second,"
+      << "distance_queries_per_second,frames_per_second,"
+      << "generations_per_second,checksum\n";
+    std::cout << std::setw(6) << "size" << std::setw(7) << "width"
+      << std::setw(7) << "curve" << std::setw(7) << "points"
+      << std::setw(12) << "rays/s" << std::setw(12) << "dists/s"
+      << std::setw(12) << "frames/s" << std::setw(10) << "gens/s"
+      << std::endl;
+
+    for (unsigned i = 0; i < shapes.size(); i++) {
+      const TrackShape& shape = shapes[i];
+      string track_folder = folder + "/track-" + std::to_string(i);
+      if (!TrackGenerator::Generate(shape, track_folder)) {
+        std::cout << "Could not write " << track_folder << std::endl;
+        return false;
+      }
+
+      Result result = Measure(shape, track_folder);
+      csv << shape.size << "," << shape.road_width << "," << shape.curvature
+        << "," << shape.checkpoint_count << "," << result.rays_per_second
+        << "," << result.distance_queries_per_second << ","
+        << result.frames_per_second << "," << result.generations_per_second
+        << "," << result.checksum << "\n";
+      std::cout << std::setw(6) << shape.size << std::setw(7)
+        << shape.road_width << std::setw(7) << std::setprecision(2)
+        << std::fixed << shape.curvature << std::setw(7)
+        << shape.checkpoint_count << std::setprecision(0) << std::setw(12)
+        << result.rays_per_second << std::setw(12)
+        << result.distance_queries_per_second << std::setw(12)
+        << result.frames_per_second << std::setprecision(2) << std::setw(10)
+        << result.generations_per_second << std::endl;
+    }
+    return true;
+  }
+}
\ No newline at end of file
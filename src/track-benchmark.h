@@ -0,0 +1,43 @@
+#pragma once
+
+#include "track-generator.h"
+
+// Times the simulator on generated tracks to show how it scales with track
+// size, road width, curvature and checkpoint count. Each parameter is swept
+// on its own while the others keep their TrackShape defaults.
+namespace TrackBenchmark {
+
+  // Values swept for each TrackShape parameter
+  const vector<int> kSizes = { 512, 1024, 2048, 4096 };
+  const vector<int> kRoadWidths = { 50, 100, 200 };
+  const vector<float> kCurvatures = { 0, 0.3f, 0.6f, 0.9f };
+  const vector<int> kCheckpointCounts = { 16, 64, 256, 1024 };
+
+  // Number of CastRay and FindDistAlongTrack calls timed on each track
+  const int kQueryCount = 100000;
+
+  // Number of generations of a random population timed on each track
+  const int kGenerations = 3;
+
+  // Throughput measured on one generated track
+  struct Result {
+    TrackShape shape;
+    double rays_per_second = 0;
+    double distance_queries_per_second = 0;
+    double frames_per_second = 0;
+    double generations_per_second = 0;
+
+    // Sum of every ray distance and distance along the track measured.
+    // Written out so the timed queries are not optimized away, and changes
+    // if their results do.
+    double checksum = 0;
+  };
+
+  // Generates a track of shape in folder and times it
+  Result Measure(const TrackShape& shape, string folder);
+
+  // Runs every sweep with tracks generated under folder. Prints a table and
+  // writes it to benchmark.csv in folder for charting. Returns false if a
+  // track could not be generated.
+  bool Run(string folder);
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "track-evaluator.h"
+
+TrackEvaluator::TrackEvaluator(Track* track, int max_frames) {
+  this->track_ = track;
+  this->max_frames_ = max_frames;
+}
+
+Track* TrackEvaluator::GetTrack() const {
+  return track_;
+}
+
+void TrackEvaluator::SetDeterministicPhysics(bool deterministic_physics) {
+  this->deterministic_physics_ = deterministic_physics;
+}
+
+void TrackEvaluator::SetDecisionInterval(int decision_interval) {
+  this->decision_interval_ = decision_interval;
+}
+
+void TrackEvaluator::SetQuantizedInference(bool quantized_inference) {
+  this->quantized_inference_ = quantized_inference;
+}
+
+void TrackEvaluator::SetStartSegment(int start_segment) {
+  this->start_segment_ = start_segment;
+}
+
+vector<float> TrackEvaluator::Evaluate(
+  const vector<NeuralNetwork*>& networks,
+  const std::atomic<bool>* stop) const {
+
+  vector<QuantizedNetwork> quantized_networks(quantized_inference_
+    ? networks.size() : 0);
+  vector<Car> cars;
+  cars.reserve(networks.size());
+  for (unsigned i = 0; i < networks.size(); i++) {
+    cars.push_back(Car(track_, i, networks[i]));
+    if (quantized_inference_ && quantized_networks[i].Quantize(networks[i])) {
+      cars.back().SetQuantizedNetwork(&quantized_networks[i]);
+    }
+    if (start_segment_ != 0) {
+      cars.back().StartAtSegment(start_segment_);
+    }
+    cars.back().SetDeterministic(deterministic_physics_);
+    cars.back().SetDecisionInterval(decision_interval_);
+  }
+
+  float start_fitness = cars.empty() ? 0 : cars[0].GetFitness();
+  unsigned disabled_count = 0;
+  for (int frame = 0; frame < max_frames_
+    && disabled_count < cars.size(); frame++) {
+    if (stop != nullptr && *stop) {
+      break;
+    }
+    for (Car &car : cars) {
+      if (car.IsDisabled()) {
+        continue;
+      }
+
+      car.FrameUpdate(car.NextInputs());
+      if (car.IsDisabled()) {
+        disabled_count++;
+      }
+    }
+  }
+
+  vector<float> fitnesses(cars.size());
+  for (unsigned i = 0; i < cars.size(); i++) {
+    fitnesses[i] = cars[i].GetFitness() - start_fitness;
+  }
+  return fitnesses;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include "car.h"
+
+// Drives a population of NeuralNetworks on a single Track without rendering.
+// The Track and NeuralNetworks are only read, so several TrackEvaluators can
+// share them while running on separate threads.
+class TrackEvaluator {
+
+public:
+
+  // Constructs evaluator that runs at most max_frames frames on a Track
+  TrackEvaluator(Track* track, int max_frames);
+
+  // Returns Track this evaluator drives on
+  Track* GetTrack() const;
+
+  // Makes evaluated Cars use deterministic fixed-point physics
+  void SetDeterministicPhysics(bool deterministic_physics);
+
+  // Sets number of frames evaluated Cars hold their inputs for
+  void SetDecisionInterval(int decision_interval);
+
+  // Makes evaluated Cars drive with int8 quantized copies of their networks,
+  // as the population does in quantized inference
+  void SetQuantizedInference(bool quantized_inference);
+
+  // Makes evaluated Cars start at a track path segment, facing along it,
+  // instead of at the track's start
+  void SetStartSegment(int start_segment);
+
+  // Drives one headless Car per network until all have crashed or
+  // max_frames_ have passed. Returns progress of each network in order,
+  // measured from the start segment. If stop is given, it is checked every
+  // frame and the run ends early once it is set, returning progress so far.
+  vector<float> Evaluate(const vector<NeuralNetwork*>& networks,
+    const std::atomic<bool>* stop = nullptr) const;
+
+private:
+
+  // Track to evaluate networks on. Not owned by the evaluator.
+  Track* track_;
+
+  // Maximum number of frames to drive each Car
+  int max_frames_;
+
+  // True if evaluated Cars use deterministic physics
+  bool deterministic_physics_ = false;
+
+  // Number of frames between input calculations of evaluated Cars
+  int decision_interval_ = 1;
+
+  // True if evaluated Cars use quantized networks
+  bool quantized_inference_ = false;
+
+  // Track path segment evaluated Cars start at
+  int start_segment_ = 0;
+};
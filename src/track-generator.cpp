@@ -0,0 +1,103 @@
+#include "track-generator.h"
+#include <fstream>
+#include <random>
+#include "ofImage.h"
+#include "ofFileUtils.h"
+
+namespace TrackGenerator {
+
+  vector<vector<float>> GeneratePath(const TrackShape& shape) {
+    float curvature = CLAMP(shape.curvature, 0.0f, 0.9f);
+    float center = shape.size / 2.0f;
+    float mean_radius = (center - shape.road_width) / (1 + curvature);
+
+    // Radius is modulated by harmonics of random phase whose amplitudes sum
+    // to 1, so it stays within mean_radius * (1 +- curvature)
+    std::mt19937 random_engine(shape.seed);
+    std::uniform_real_distribution<float> unit(0, 1);
+    vector<float> amplitudes(kHarmonicCount);
+    vector<float> phases(kHarmonicCount);
+    float amplitude_sum = 0;
+    for (int k = 0; k < kHarmonicCount; k++) {
+      amplitudes[k] = unit(random_engine);
+      phases[k] = unit(random_engine) * TWO_PI;
+      amplitude_sum += amplitudes[k];
+    }
+
+    vector<vector<float>> path;
+    int checkpoint_count = std::max(shape.checkpoint_count, 3);
+    for (int i = 0; i < checkpoint_count; i++) {
+      float along = (float)i / checkpoint_count;
+      float angle = -HALF_PI + along * TWO_PI;
+
+      float wobble = 0;
+      for (int k = 0; k < kHarmonicCount; k++) {
+        wobble += amplitudes[k] / amplitude_sum
+          * sin((k + 2) * along * TWO_PI + phases[k]);
+      }
+
+      // The window is flat at the start, so the loop leaves it heading east
+      float window = pow(sin(along * PI), 2);
+      float radius = mean_radius * (1 + curvature * window * wobble);
+      path.push_back({ (float)(int)(center + radius * cos(angle)),
+        (float)(int)(center + radius * sin(angle)) });
+    }
+    return path;
+  }
+
+  void DrawRoad(const TrackShape& shape, const vector<vector<float>>& path,
+    ofPixels* image) {
+    image->allocate(shape.size, shape.size, OF_PIXELS_RGB);
+    image->setColor(kGrassColor);
+
+    // Each pixel near a segment is painted if it is within half the road
+    // width of it, so corners are rounded
+    float half_width = shape.road_width / 2.0f;
+    for (unsigned i = 0; i < path.size(); i++) {
+      const vector<float>& start = path[i];
+      const vector<float>& end = path[(i + 1) % path.size()];
+      float path_x = end[0] - start[0];
+      float path_y = end[1] - start[1];
+      float square_length = std::max(path_x * path_x + path_y * path_y,
+        0.000001f);
+
+      int min_x = std::max(0, (int)(std::min(start[0], end[0]) - half_width));
+      int max_x = std::min(shape.size - 1,
+        (int)(std::max(start[0], end[0]) + half_width));
+      int min_y = std::max(0, (int)(std::min(start[1], end[1]) - half_width));
+      int max_y = std::min(shape.size - 1,
+        (int)(std::max(start[1], end[1]) + half_width));
+      for (int y = min_y; y <= max_y; y++) {
+        for (int x = min_x; x <= max_x; x++) {
+          float along = CLAMP(((x - start[0]) * path_x
+            + (y - start[1]) * path_y) / square_length, 0.0f, 1.0f);
+          float offset_x = x - (start[0] + along * path_x);
+          float offset_y = y - (start[1] + along * path_y);
+          if (offset_x * offset_x + offset_y * offset_y
+            <= half_width * half_width) {
+            image->setColor(x, y, kRoadColor);
+          }
+        }
+      }
+    }
+  }
+
+  bool Generate(const TrackShape& shape, string folder) {
+    vector<vector<float>> path = GeneratePath(shape);
+    ofPixels image;
+    DrawRoad(shape, path, &image);
+
+    ofDirectory::createDirectory(folder, false, true);
+    ofFile::removeFile(folder + "/track.png", false);
+    ofSaveImage(image, folder + "/track.png");
+    if (!ofFile::doesFileExist(folder + "/track.png", false)) {
+      return false;
+    }
+
+    std::ofstream checkpoints(folder + "/checkpoints.txt");
+    for (const vector<float>& point : path) {
+      checkpoints << (int)point[0] << " " << (int)point[1] << "\n";
+    }
+    return (bool)checkpoints;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ofPixels.h"
+#include "track.h"
+
+// Parameters of a procedurally generated track
+struct TrackShape {
+  // Width and height of the track image in pixels
+  int size = 1024;
+
+  // Width of the road in pixels
+  int road_width = 100;
+
+  // How far the road's distance from the image center varies around the
+  // loop, from 0 (a circle) to 0.9. Higher values give tighter corners.
+  float curvature = 0.3f;
+
+  // Number of path points in checkpoints.txt
+  int checkpoint_count = 32;
+
+  // Seed choosing the shape of the loop
+  uint32_t seed = 1;
+};
+
+// Generates closed-loop tracks in the format of the bundled track folders: a
+// track.png of road on grass and a checkpoints.txt path along the middle of
+// the road. The loop runs clockwise from its top, where the path heads due
+// east like the bundled tracks, since Cars start facing east.
+namespace TrackGenerator {
+
+  // Colors of grass and road, matching the bundled tracks
+  const ofColor kGrassColor(141, 245, 97);
+  const ofColor kRoadColor(88, 88, 88);
+
+  // Number of random harmonics bending the loop
+  const int kHarmonicCount = 4;
+
+  // Returns the path points of a shape, in order around the loop
+  vector<vector<float>> GeneratePath(const TrackShape& shape);
+
+  // Draws road of a shape's width along a closed path on grass
+  void DrawRoad(const TrackShape& shape, const vector<vector<float>>& path,
+    ofPixels* image);
+
+  // Writes track.png and checkpoints.txt of a shape to folder, creating it
+  // if needed. Returns false if either file could not be written.
+  bool Generate(const TrackShape& shape, string folder);
+}
\ No newline at end of file
@@ -1,8 +1,19 @@
 #include "track.h"
 
 Track::Track(string folder_path) {
+  background_.setUseTexture(false);
   background_.load(folder_path + "/track.png");
   background_pixels_ = background_.getPixels();
+
+  width_ = background_pixels_.getWidth();
+  height_ = background_pixels_.getHeight();
+  track_mask_.resize(width_ * height_);
+  for (int y = 0; y < height_; y++) {
+    for (int x = 0; x < width_; x++) {
+      ofColor color = background_pixels_.getColor(x, y);
+      track_mask_[y * width_ + x] = color.g <= color.b + 100;
+    }
+  }
   InitializePath(folder_path + "/checkpoints.txt");
   assert(path_points_.size() > 1);
 
@@ -11,6 +22,7 @@ Track::Track(string folder_path) {
   vector<float> previous = start_position_;
   for (vector<float> point : path_points_) {
     path_length += sqrt(GetSquareDist(previous, point));
+    path_distances_.push_back(path_length);
     previous = point;
   }
   path_length += sqrt(GetSquareDist(start_position_,
@@ -18,6 +30,23 @@ Track::Track(string folder_path) {
   track_length_ = path_length;
 }
 
+vector<string> Track::GetBundledTrackFolders(string assets_path) {
+  vector<string> track_folders;
+  for (int i = 1; i <= kBundledTrackCount; i++) {
+    track_folders.push_back(assets_path + "/track" + std::to_string(i));
+  }
+  return track_folders;
+}
+
+void Track::DrawBackground() {
+  if (!background_.isUsingTexture()) {
+    background_.setUseTexture(true);
+    background_.update();
+  }
+  background_.draw(0, 0, background_.getWidth() * scale_,
+    background_.getHeight() * scale_);
+}
+
 ofColor Track::GetBackgroundColor() const {
   return background_pixels_.getColor(0, 0);
 }
@@ -49,13 +78,10 @@ void Track::SetScale(float scale) {
 }
 
 bool Track::PointIsOnTrack(int x, int y) const {
-  if (x < 0 || y < 0
-    || x >= background_.getWidth()
-    || y >= background_.getHeight()) {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) {
     return false;
   }
-  ofColor color = background_pixels_.getColor(x, y);
-  return color.g <= color.b + 100;
+  return track_mask_[y * width_ + x] != 0;
 }
 
 void Track::InitializePath(string data_filepath) {
@@ -96,6 +122,87 @@ float Track::FindDistAlongTrack(vector<float> position) const {
   return 0;
 }
 
+int Track::GetSegmentCount() const {
+  return path_points_.size();
+}
+
+int Track::AdvanceSegment(const vector<float>& position, int* segment) const {
+  int segment_count = path_points_.size();
+  int laps = 0;
+  float square_dist = GetSquareDistToSegment(position, *segment);
+
+  // Cars move far less than a segment per frame, so this usually stops
+  // after comparing one neighbour on each side
+  while (true) {
+    int next = (*segment + 1) % segment_count;
+    int previous = (*segment - 1 + segment_count) % segment_count;
+    float next_square_dist = GetSquareDistToSegment(position, next);
+    float previous_square_dist = GetSquareDistToSegment(position, previous);
+
+    if (next_square_dist < square_dist
+      && next_square_dist <= previous_square_dist) {
+      if (next == 0) {
+        laps++;
+      }
+      *segment = next;
+      square_dist = next_square_dist;
+    } else if (previous_square_dist < square_dist) {
+      if (*segment == 0) {
+        laps--;
+      }
+      *segment = previous;
+      square_dist = previous_square_dist;
+    } else {
+      return laps;
+    }
+  }
+}
+
+vector<float> Track::GetSegmentStart(int segment) const {
+  return path_points_[segment];
+}
+
+float Track::GetSegmentHeading(int segment) const {
+  const vector<float>& start = path_points_[segment];
+  const vector<float>& end = path_points_[(segment + 1) % path_points_.size()];
+  return atan2(end[1] - start[1], end[0] - start[0]);
+}
+
+float Track::GetDistAlongSegment(const vector<float>& position,
+  int segment) const {
+  int next = (segment + 1) % path_points_.size();
+  float segment_length = sqrt(GetSquareDist(path_points_[segment],
+    path_points_[next]));
+  return path_distances_[segment]
+    + ProjectOntoSegment(position, segment) * segment_length;
+}
+
+float Track::ProjectOntoSegment(const vector<float>& position,
+  int segment) const {
+  const vector<float>& start = path_points_[segment];
+  const vector<float>& end = path_points_[(segment + 1) % path_points_.size()];
+  float path_x = end[0] - start[0];
+  float path_y = end[1] - start[1];
+  float square_length = path_x * path_x + path_y * path_y;
+  if (square_length < kEpsilon) {
+    return 0;
+  }
+
+  float projection_coefficient = ((position[0] - start[0]) * path_x
+    + (position[1] - start[1]) * path_y) / square_length;
+  return CLAMP(projection_coefficient, 0.0f, 1.0f);
+}
+
+float Track::GetSquareDistToSegment(const vector<float>& position,
+  int segment) const {
+  const vector<float>& start = path_points_[segment];
+  const vector<float>& end = path_points_[(segment + 1) % path_points_.size()];
+  float along = ProjectOntoSegment(position, segment);
+  float closest_x = start[0] + along * (end[0] - start[0]);
+  float closest_y = start[1] + along * (end[1] - start[1]);
+  return pow(position[0] - closest_x, 2) + pow(position[1] - closest_y, 2);
+}
+
 vector<vector<float>> Track::FindClosestTwoPathPoints(
   vector<float> point) const {
 
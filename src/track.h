@@ -9,13 +9,24 @@ using std::vector;
 class Track {
 public:
 
+  // Number of track folders bundled in assets (track1, track2, ...)
+  static const int kBundledTrackCount = 3;
+
+  // Returns folder of every bundled track in an assets directory
+  static vector<string> GetBundledTrackFolders(string assets_path);
+
   // Track background image
   ofImage background_;
 
   // Constructs track from folder path relative to src folder. Requires
-  // background image and text file with path points.
+  // background image and text file with path points. Does not need a GL
+  // context, so tracks can be loaded on a worker thread.
   Track(string folder_path);
 
+  // Draws background image at track scale. Uploads the background texture
+  // on the first call, which must be on the GL thread.
+  void DrawBackground();
+
   // Returns color of top-left pixel
   ofColor GetBackgroundColor() const;
 
@@ -34,7 +45,8 @@ public:
   // Returns scale of track as float
   float GetScale() const;
 
-  // Sets track scale for path points, start position, and background image
+  // Sets scale the track and its Cars are drawn at. Simulation always runs in
+  // the background image's native pixels, so nothing is rebuilt.
   void SetScale(float scale);
 
   // Fills path_points with path coordinates from text file path
@@ -43,9 +55,30 @@ public:
   // Returns true if the given coordinate is a legal pixel for a Car to be on
   bool PointIsOnTrack(int x, int y) const;
 
-  // Calculates distance along path to a given point on the track.
+  // Calculates distance along path to a given point on the track by searching
+  // every path point.
   float FindDistAlongTrack(vector<float> position) const;
 
+  // Returns number of path segments. Segment i runs from path point i to the
+  // next one; the last segment closes the loop back to the start.
+  int GetSegmentCount() const;
+
+  // Moves segment to the path segment nearest position, walking only between
+  // adjacent segments from the segment given. Returns the number of times the
+  // walk crossed the start line, negative if it crossed going backwards.
+  int AdvanceSegment(const vector<float>& position, int* segment) const;
+
+  // Returns first path point of a segment, where Cars start when evaluated
+  // from that segment
+  vector<float> GetSegmentStart(int segment) const;
+
+  // Returns heading in radians (0 is due east) from a segment's first path
+  // point to its second
+  float GetSegmentHeading(int segment) const;
+
+  // Returns distance along path to position, measured along a given segment
+  float GetDistAlongSegment(const vector<float>& position, int segment) const;
+
 private:
 
   // Epsilon for comparing floats
@@ -54,12 +87,23 @@ private:
   // Amount to decrease car velocity each frame
   const float kFriction = 0.02f;
 
-  // openFrameworks object with background image pixels. Used in PointIsOnTrack
+  // openFrameworks object with background image pixels
   ofPixels background_pixels_;
 
+  // One byte per background pixel, nonzero where PointIsOnTrack is true.
+  // Precomputed so ray casts read a byte instead of decoding a color.
+  vector<unsigned char> track_mask_;
+
+  // Dimensions of the background image in pixels
+  int width_;
+  int height_;
+
   // List of 2D points defining track's path
   vector<vector<float>> path_points_;
 
+  // Distance along path from the start to each path point
+  vector<float> path_distances_;
+
   // Starting point of cars on this track
   vector<float> start_position_;
 
@@ -79,4 +123,12 @@ private:
 
   // Calculates the square of the distance between two points.
   float GetSquareDist(vector<float> first, vector<float> second) const;
+
+  // Returns how far along a segment the point on it nearest position is, from
+  // 0 at its first path point to 1 at its second
+  float ProjectOntoSegment(const vector<float>& position, int segment) const;
+
+  // Returns square of the distance from position to a segment
+  float GetSquareDistToSegment(const vector<float>& position,
+    int segment) const;
 };
\ No newline at end of file
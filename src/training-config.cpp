@@ -0,0 +1,61 @@
+#include "training-config.h"
+#include <sstream>
+#include "car.h"
+
+bool TrainingConfig::Set(string key, string value) {
+  try {
+    if (key == "population_size") {
+      population_size = std::stoi(value);
+      return population_size > 0;
+    }
+    if (key == "selection_standard_deviation") {
+      selection_standard_deviation = std::stof(value);
+      return selection_standard_deviation > 0;
+    }
+    if (key == "copy_to_next_generation") {
+      copy_to_next_generation = std::stoi(value);
+      return copy_to_next_generation >= 0;
+    }
+    if (key == "mutation_rate") {
+      mutation_rate = std::stof(value);
+      return mutation_rate >= 0;
+    }
+    if (key == "architecture") {
+      vector<int> layers;
+      std::stringstream sizes(value);
+      string size;
+      while (std::getline(sizes, size, '-')) {
+        layers.push_back(std::stoi(size));
+        if (layers.back() <= 0) {
+          return false;
+        }
+      }
+      if (layers.size() < 2) {
+        return false;
+      }
+      architecture = layers;
+      return true;
+    }
+  } catch (const std::exception&) {
+    return false;
+  }
+  return false;
+}
+
+bool TrainingConfig::IsValid() const {
+  return population_size > 0 && copy_to_next_generation <= population_size
+    && architecture.size() >= 2 && architecture.front() <= Car::kNnInputCount
+    && architecture.back() == 2;
+}
+
+string TrainingConfig::ToString() const {
+  std::stringstream out;
+  out << "population_size=" << population_size
+    << " selection_standard_deviation=" << selection_standard_deviation
+    << " copy_to_next_generation=" << copy_to_next_generation
+    << " mutation_rate=" << mutation_rate << " architecture=";
+  for (unsigned i = 0; i < architecture.size(); i++) {
+    out << (i > 0 ? "-" : "") << architecture[i];
+  }
+  return out.str();
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Hyperparameters of a training run. Defaults are the values the applet
+// trains with.
+struct TrainingConfig {
+  // Number of Cars in each generation
+  int population_size = 50;
+
+  // Standard deviation of Car rankings chosen as parents for next
+  // generation's offspring. Should be no more than population_size / 3
+  float selection_standard_deviation = 6;
+
+  // Number of top-performing Cars to directly copy to next generation
+  int copy_to_next_generation = 8;
+
+  // Largest change to each offspring parameter when mutating. Higher is more
+  // mutation.
+  float mutation_rate = 1.0;
+
+  // Architecture of Car NeuralNetworks. Each int represents the number of
+  // nodes in a layer
+  vector<int> architecture = { 4, 3, 3, 2 };
+
+  // Sets the field named key (population_size, selection_standard_deviation,
+  // copy_to_next_generation, mutation_rate or architecture) from value.
+  // Architecture layer sizes are separated by '-'. Returns false if the key
+  // is unknown or the value is malformed.
+  bool Set(string key, string value);
+
+  // Returns true if the fields can train together: at most population_size
+  // Cars are copied, networks read no more inputs than a Car provides, and
+  // networks output acceleration and turning
+  bool IsValid() const;
+
+  // Returns every field as key=value pairs separated by spaces
+  string ToString() const;
+};
\ No newline at end of file
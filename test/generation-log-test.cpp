@@ -0,0 +1,125 @@
+#include "test.h"
+#include <cstdio>
+#include <filesystem>
+#include "../src/generation-log.h"
+
+namespace {
+
+  // Builds a record whose every field is derived from its generation
+  GenerationRecord MakeRecord(int generation) {
+    GenerationRecord record;
+    record.generation = generation;
+    record.top_fitness = generation * 1.5f;
+    record.mean_fitness = generation * 0.5f;
+    record.disabled_count = generation % 7;
+    record.frame_count = generation * 10;
+    record.genome_size = 3;
+    for (int k = 0; k < 2; k++) {
+      record.top_fitnesses.push_back(generation - k);
+      for (int p = 0; p < record.genome_size; p++) {
+        record.top_genomes.push_back(generation + k * 0.25 + p * 0.125);
+      }
+    }
+    return record;
+  }
+
+  // Returns true if record matches MakeRecord(generation) exactly
+  bool MatchesRecord(const GenerationRecord& record, int generation) {
+    GenerationRecord expected = MakeRecord(generation);
+    return record.generation == expected.generation
+      && record.top_fitness == expected.top_fitness
+      && record.mean_fitness == expected.mean_fitness
+      && record.disabled_count == expected.disabled_count
+      && record.frame_count == expected.frame_count
+      && record.genome_size == expected.genome_size
+      && record.top_fitnesses == expected.top_fitnesses
+      && record.top_genomes == expected.top_genomes;
+  }
+
+  // Writes generations first to last, closing the log when done
+  void WriteGenerations(string path, int first, int last) {
+    GenerationLogWriter writer(path);
+    CHECK(writer.IsOpen());
+    for (int generation = first; generation <= last; generation++) {
+      writer.Append(MakeRecord(generation));
+    }
+  }
+
+  void TestRoundTrip() {
+    string path = Test::ScratchPath("round-trip.glog");
+    std::remove(path.c_str());
+
+    // More than one chunk of 64 records, ending in a partial chunk
+    WriteGenerations(path, 1, 150);
+
+    GenerationLogReader reader;
+    CHECK(reader.Open(path));
+    CHECK(reader.GetFirstGeneration() == 1);
+    CHECK(reader.GetLastGeneration() == 150);
+    for (int generation = 1; generation <= 150; generation++) {
+      GenerationRecord record;
+      CHECK(reader.Read(generation, &record));
+      CHECK(MatchesRecord(record, generation));
+    }
+    GenerationRecord record;
+    CHECK(!reader.Read(151, &record));
+    std::remove(path.c_str());
+  }
+
+  void TestTruncatedChunk() {
+    string path = Test::ScratchPath("truncated.glog");
+    std::remove(path.c_str());
+
+    // One full chunk of 64 records, then a chunk of 6 cut short as by a
+    // crash partway through writing it
+    WriteGenerations(path, 1, 70);
+    uint64_t size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - 5);
+
+    // The cut chunk is dropped and the records appended after it readable
+    WriteGenerations(path, 71, 80);
+
+    GenerationLogReader reader;
+    CHECK(reader.Open(path));
+    CHECK(reader.GetFirstGeneration() == 1);
+    CHECK(reader.GetLastGeneration() == 80);
+    GenerationRecord record;
+    CHECK(reader.Read(64, &record) && MatchesRecord(record, 64));
+    CHECK(!reader.Read(65, &record));
+    CHECK(!reader.Read(70, &record));
+    for (int generation = 71; generation <= 80; generation++) {
+      CHECK(reader.Read(generation, &record));
+      CHECK(MatchesRecord(record, generation));
+    }
+    std::remove(path.c_str());
+  }
+
+  void TestNotALog() {
+    string path = Test::ScratchPath("not-a-log.glog");
+    FILE* file = std::fopen(path.c_str(), "wb");
+    std::fputs("not a generation log", file);
+    std::fclose(file);
+
+    // The writer leaves files it does not recognize alone
+    {
+      GenerationLogWriter writer(path);
+      CHECK(!writer.IsOpen());
+      writer.Append(MakeRecord(1));
+      CHECK(writer.GetDroppedCount() == 1);
+    }
+    CHECK(std::filesystem::file_size(path) == 20);
+
+    GenerationLogReader reader;
+    CHECK(!reader.Open(path));
+    std::remove(path.c_str());
+  }
+}
+
+namespace GenerationLogTest {
+
+  void Run() {
+    TestRoundTrip();
+    TestTruncatedChunk();
+    TestNotALog();
+  }
+}
\ No newline at end of file
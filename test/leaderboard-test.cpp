@@ -0,0 +1,85 @@
+#include "test.h"
+#include <algorithm>
+#include <limits>
+#include <random>
+#include "../src/leaderboard.h"
+
+namespace {
+
+  // Returns every slot ranked by a stable sort: highest fitness first, ties
+  // to the lower index
+  vector<LeaderboardEntry> SortSlots(const vector<float>& fitness) {
+    vector<LeaderboardEntry> sorted;
+    for (unsigned i = 0; i < fitness.size(); i++) {
+      sorted.push_back(LeaderboardEntry(i, fitness[i]));
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+      [](const LeaderboardEntry& first, const LeaderboardEntry& second) {
+        return first.fitness > second.fitness;
+      });
+    return sorted;
+  }
+
+  // Returns true if the leaderboard's top count slots match a stable sort
+  bool MatchesSort(const Leaderboard& leaderboard,
+    const vector<float>& fitness, int count) {
+    vector<LeaderboardEntry> top = leaderboard.GetTop(count);
+    vector<LeaderboardEntry> sorted = SortSlots(fitness);
+    if ((int)top.size() != std::min<int>(std::max(count, 0), sorted.size())) {
+      return false;
+    }
+    for (unsigned i = 0; i < top.size(); i++) {
+      if (top[i].index != sorted[i].index
+        || top[i].fitness != sorted[i].fitness) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void TestEmpty() {
+    Leaderboard leaderboard;
+    leaderboard.Reset(0);
+    CHECK(leaderboard.GetSize() == 0);
+    CHECK(leaderboard.GetLeader().index == -1);
+    CHECK(leaderboard.GetTop(5).empty());
+  }
+
+  void TestAgainstSort() {
+    std::mt19937 random_engine(35);
+
+    // Few distinct fitness values, so many slots tie
+    std::uniform_int_distribution<int> fitness_step(-3, 3);
+
+    for (int size : { 1, 2, 3, 5, 7, 8, 9, 13, 64, 100 }) {
+      Leaderboard leaderboard;
+      leaderboard.Reset(size);
+      vector<float> fitness(size, std::numeric_limits<float>::lowest());
+      CHECK(leaderboard.GetSize() == size);
+      CHECK(MatchesSort(leaderboard, fitness, size));
+
+      std::uniform_int_distribution<int> slot(0, size - 1);
+      for (int update = 0; update < 4 * size; update++) {
+        int index = slot(random_engine);
+        fitness[index] = fitness_step(random_engine) * 0.5f;
+        leaderboard.Update(index, fitness[index]);
+
+        LeaderboardEntry leader = leaderboard.GetLeader();
+        LeaderboardEntry expected = SortSlots(fitness)[0];
+        CHECK(leader.index == expected.index
+          && leader.fitness == expected.fitness);
+        for (int count : { 0, 1, 3, size - 1, size, size + 2 }) {
+          CHECK(MatchesSort(leaderboard, fitness, count));
+        }
+      }
+    }
+  }
+}
+
+namespace LeaderboardTest {
+
+  void Run() {
+    TestEmpty();
+    TestAgainstSort();
+  }
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#include "test.h"
+#include "ofMain.h"
+#include "../src/physics-regression.h"
+
+namespace PhysicsRegressionTest {
+
+  void Run() {
+    // Tracks load their images through openFrameworks
+    ofInit();
+    vector<string> track_folders = Track::GetBundledTrackFolders(
+      ofFilePath::getCurrentWorkingDirectory() + "/assets");
+    CHECK(PhysicsRegression::VerifyTracks(track_folders));
+  }
+}
\ No newline at end of file
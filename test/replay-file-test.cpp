@@ -0,0 +1,125 @@
+#include "test.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "../src/replay.h"
+#include "../src/fixed-point.h"
+
+namespace {
+
+  // Builds a replay that exercises one-byte, multi-byte and sign-changing
+  // deltas
+  Replay MakeReplay() {
+    Replay replay;
+    replay.track_folder = "assets/track1";
+    replay.generation = 42;
+    replay.fitness = 1234.5f;
+    replay.genome_hash = 0x0123456789ABCDEFULL;
+    replay.final_state_hash = 0xFEDCBA9876543210ULL;
+
+    const int32_t inputs[] = { 0, 0, 1, -1, 63, -64, 64, -65, 8191, -8192,
+      FixedPoint::kOne, -FixedPoint::kOne, 1 << 24, -(1 << 24), 0 };
+    for (int32_t acceleration : inputs) {
+      replay.accelerations.push_back(acceleration);
+      replay.turnings.push_back(-acceleration / 2);
+    }
+    return replay;
+  }
+
+  // Overwrites the little-endian uint32 at offset in a file
+  void PatchUint32(string path, int offset, uint32_t value) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(offset);
+    for (int byte = 0; byte < 4; byte++) {
+      file.put((char)((value >> (8 * byte)) & 0xFF));
+    }
+  }
+
+  void TestRoundTrip() {
+    string path = Test::ScratchPath("round-trip.replay");
+    Replay replay = MakeReplay();
+    CHECK(ReplayFile::Write(replay, path));
+
+    Replay read;
+    CHECK(ReplayFile::Read(path, &read));
+    CHECK(read.track_folder == replay.track_folder);
+    CHECK(read.generation == replay.generation);
+    CHECK(read.fitness == replay.fitness);
+    CHECK(read.genome_hash == replay.genome_hash);
+    CHECK(read.final_state_hash == replay.final_state_hash);
+    CHECK(read.accelerations == replay.accelerations);
+    CHECK(read.turnings == replay.turnings);
+    std::remove(path.c_str());
+  }
+
+  void TestHeldInputsTakeOneByte() {
+    string path = Test::ScratchPath("held.replay");
+    Replay replay;
+    CHECK(ReplayFile::Write(replay, path));
+    uint64_t empty_size = std::filesystem::file_size(path);
+
+    replay.accelerations.assign(1000, FixedPoint::kOne);
+    replay.turnings.assign(1000, -FixedPoint::kOne);
+    CHECK(ReplayFile::Write(replay, path));
+
+    // Only the first frame differs from the previous one
+    uint64_t first_frame_bytes = 2 * 4;
+    CHECK(std::filesystem::file_size(path)
+      <= empty_size + first_frame_bytes + 2 * 999);
+
+    Replay read;
+    CHECK(ReplayFile::Read(path, &read));
+    CHECK(read.accelerations == replay.accelerations);
+    CHECK(read.turnings == replay.turnings);
+    std::remove(path.c_str());
+  }
+
+  void TestTruncatedFile() {
+    string path = Test::ScratchPath("truncated.replay");
+    CHECK(ReplayFile::Write(MakeReplay(), path));
+    uint64_t size = std::filesystem::file_size(path);
+
+    // Cutting into the last varint must fail rather than return a short run
+    std::filesystem::resize_file(path, size - 1);
+    Replay read;
+    CHECK(!ReplayFile::Read(path, &read));
+
+    // So must cutting into the track folder name
+    std::filesystem::resize_file(path, 16);
+    CHECK(!ReplayFile::Read(path, &read));
+    std::remove(path.c_str());
+  }
+
+  void TestOversizedHeader() {
+    string path = Test::ScratchPath("oversized.replay");
+    Replay replay = MakeReplay();
+    Replay read;
+
+    // Folder length follows the magic and version
+    CHECK(ReplayFile::Write(replay, path));
+    PatchUint32(path, 8, 0xFFFFFFF0);
+    CHECK(!ReplayFile::Read(path, &read));
+
+    // Frame count follows the folder, generation, fitness and two hashes
+    CHECK(ReplayFile::Write(replay, path));
+    int frame_count_offset = 12 + replay.track_folder.size() + 8 + 16;
+    PatchUint32(path, frame_count_offset, 0xFFFFFFF0);
+    CHECK(!ReplayFile::Read(path, &read));
+
+    // One frame more than the file holds is also rejected
+    CHECK(ReplayFile::Write(replay, path));
+    PatchUint32(path, frame_count_offset, replay.accelerations.size() + 1);
+    CHECK(!ReplayFile::Read(path, &read));
+    std::remove(path.c_str());
+  }
+}
+
+namespace ReplayFileTest {
+
+  void Run() {
+    TestRoundTrip();
+    TestHeldInputsTakeOneByte();
+    TestTruncatedFile();
+    TestOversizedHeader();
+  }
+}
\ No newline at end of file
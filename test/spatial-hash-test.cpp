@@ -0,0 +1,91 @@
+#include "test.h"
+#include <algorithm>
+#include <random>
+#include "../src/spatial-hash.h"
+
+namespace {
+
+  // Returns sorted ids of points within radius of (x, y) by checking every
+  // point
+  vector<int> FindNearByScan(const vector<HashedPoint>& points, float x,
+    float y, float radius) {
+    vector<int> ids;
+    for (const HashedPoint& point : points) {
+      float dx = point.x - x;
+      float dy = point.y - y;
+      if (dx * dx + dy * dy <= radius * radius) {
+        ids.push_back(point.id);
+      }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  }
+
+  void TestEmpty() {
+    SpatialHash hash(50);
+    vector<int> ids;
+    hash.FindNear(10, 10, 100, &ids);
+    CHECK(ids.empty());
+
+    hash.Build(vector<HashedPoint>(), 200, 100);
+    hash.FindNear(10, 10, 100, &ids);
+    CHECK(hash.GetSize() == 0);
+    CHECK(ids.empty());
+  }
+
+  void TestAgainstScan() {
+    std::mt19937 random_engine(41);
+    SpatialHash hash(50);
+
+    // Rebuilding one hash at several sizes also covers reused buffers
+    for (int area : { 40, 200, 1000 }) {
+      int width = area;
+      int height = area / 2 + 7;
+
+      // Points and queries reach past every edge of the grid
+      std::uniform_real_distribution<float> x_position(-100, width + 100);
+      std::uniform_real_distribution<float> y_position(-100, height + 100);
+      std::uniform_real_distribution<float> radius(0, 120);
+
+      vector<HashedPoint> points;
+      for (int i = 0; i < 300; i++) {
+        points.push_back(HashedPoint(i, x_position(random_engine),
+          y_position(random_engine)));
+      }
+      hash.Build(points, width, height);
+      CHECK(hash.GetSize() == (int)points.size());
+
+      for (int query = 0; query < 500; query++) {
+        float x = x_position(random_engine);
+        float y = y_position(random_engine);
+        float query_radius = radius(random_engine);
+
+        vector<int> ids;
+        hash.FindNear(x, y, query_radius, &ids);
+        std::sort(ids.begin(), ids.end());
+        CHECK(ids == FindNearByScan(points, x, y, query_radius));
+      }
+    }
+  }
+
+  void TestPointOnQuery() {
+    SpatialHash hash(50);
+    vector<HashedPoint> points = { HashedPoint(7, -30, 500),
+      HashedPoint(8, 90, 90) };
+    hash.Build(points, 100, 100);
+
+    // A zero radius finds points exactly at the query, also off the grid
+    vector<int> ids;
+    hash.FindNear(-30, 500, 0, &ids);
+    CHECK(ids == vector<int>{ 7 });
+  }
+}
+
+namespace SpatialHashTest {
+
+  void Run() {
+    TestEmpty();
+    TestAgainstScan();
+    TestPointOnQuery();
+  }
+}
\ No newline at end of file
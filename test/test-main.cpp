@@ -0,0 +1,35 @@
+#include "test.h"
+#include <iostream>
+
+namespace Test {
+
+  int failure_count = 0;
+
+  void Check(bool condition, const char* expression, const char* file,
+    int line) {
+    if (!condition) {
+      failure_count++;
+      std::cerr << file << ":" << line << ": check failed: " << expression
+        << std::endl;
+    }
+  }
+
+  string ScratchPath(string name) {
+    return "test-scratch-" + name;
+  }
+}
+
+int main() {
+  GenerationLogTest::Run();
+  ReplayFileTest::Run();
+  LeaderboardTest::Run();
+  SpatialHashTest::Run();
+  PhysicsRegressionTest::Run();
+
+  if (Test::failure_count > 0) {
+    std::cerr << Test::failure_count << " checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "All tests passed" << std::endl;
+  return 0;
+}
\ No newline at end of file
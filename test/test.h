@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+
+using std::string;
+
+// Minimal checks shared by the tests. A failed check prints its expression
+// and location, and makes test-main return nonzero.
+namespace Test {
+
+  // Number of checks that have failed so far
+  extern int failure_count;
+
+  // Records a failure if condition is false
+  void Check(bool condition, const char* expression, const char* file,
+    int line);
+
+  // Returns a path for a scratch file in the working directory
+  string ScratchPath(string name);
+}
+
+#define CHECK(condition) \
+  Test::Check((condition), #condition, __FILE__, __LINE__)
+
+// Round-trips GenerationRecords through a log, including a log cut short by
+// a crash and appended to afterward
+namespace GenerationLogTest {
+  void Run();
+}
+
+// Round-trips Replays through ReplayFile's zigzag varint encoding
+namespace ReplayFileTest {
+  void Run();
+}
+
+// Checks deterministic physics on each bundled track against its golden
+// hashes, as the --verify-physics flag does. Run from the folder holding
+// assets.
+namespace PhysicsRegressionTest {
+  void Run();
+}
+
+// Compares Leaderboard rankings with a stable sort
+namespace LeaderboardTest {
+  void Run();
+}
+
+// Compares SpatialHash radius queries with a scan of every point
+namespace SpatialHashTest {
+  void Run();
+}
\ No newline at end of file